@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstring>
+#include "Transport.h"
+#include "UringReactor.h"
+
+// Common to the benchmark programs: the serial backend named on the command line (asio by default)
+inline bool SelectSerialBackend( const char* szName )
+{
+    if( szName == nullptr || std::strcmp( szName, "asio" ) == 0 ) {
+        CTransport::SetSerialBackend( CTransport::ESerialBackend::Asio );
+    } else if( std::strcmp( szName, "epoll" ) == 0 ) {
+        CTransport::SetSerialBackend( CTransport::ESerialBackend::Epoll );
+    } else if( std::strcmp( szName, "uring" ) == 0 ) {
+        CTransport::SetSerialBackend( CTransport::ESerialBackend::IoUring );
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// What serves the ports: io_uring falls back to epoll on the kernels without it, and reads single-shot before Linux 6.7.
+// Creates the io_uring reactor thread, so not before the device process is forked
+inline const char* DescribeSerialBackend()
+{
+    switch( CTransport::GetSerialBackend() ) {
+        case CTransport::ESerialBackend::Asio: return "asio";
+        case CTransport::ESerialBackend::Epoll: return "epoll";
+        case CTransport::ESerialBackend::IoUring: break;
+    }
+    const CUringReactor* pReactor = CUringReactor::Instance();
+    if( pReactor == nullptr ) {
+        return "epoll (no io_uring)";
+    }
+    return pReactor->HasMultishotRead() ? "io_uring (multishot reads)" : "io_uring (single-shot reads)";
+}
@@ -0,0 +1,86 @@
+#include "DeviceEmulator.h"
+#include <csignal>
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "SSPFrameDecoder.h"
+#include "SSPFrameEncoder.h"
+#include "ssp_defines.h"
+
+CPtyDeviceEmulator::CPtyDeviceEmulator( uint8_t nAddress )
+    : m_nAddress( nAddress )
+{
+    m_nMaster = ::posix_openpt( O_RDWR | O_NOCTTY );
+    if( m_nMaster < 0 || ::grantpt( m_nMaster ) != 0 || ::unlockpt( m_nMaster ) != 0 ) {
+        return;
+    }
+    termios tio{};
+    ::tcgetattr( m_nMaster, &tio );
+    ::cfmakeraw( &tio );
+    ::tcsetattr( m_nMaster, TCSANOW, &tio );
+    m_strSlaveName = ::ptsname( m_nMaster );
+}
+
+CPtyDeviceEmulator::~CPtyDeviceEmulator()
+{
+    if( m_nPid > 0 ) {
+        ::kill( m_nPid, SIGKILL );
+        ::waitpid( m_nPid, nullptr, 0 );
+    }
+    if( m_nMaster >= 0 ) {
+        ::close( m_nMaster );
+    }
+}
+
+bool CPtyDeviceEmulator::Start()
+{
+    if( m_strSlaveName.empty() ) {
+        return false;
+    }
+    m_nPid = ::fork();
+    if( m_nPid == 0 ) {
+        _run();
+        ::_exit( 0 );
+    }
+    return m_nPid > 0;
+}
+
+void CPtyDeviceEmulator::_run()
+{
+    CSSPFrameDecoder decoder;
+    uint8_t rxData[ 512 ];
+    for( ;; ) {
+        const ssize_t nRead = ::read( m_nMaster, rxData, sizeof( rxData ) );
+        if( nRead <= 0 ) {
+            return;
+        }
+        decoder.Feed( rxData, static_cast< size_t >( nRead ), [ this ]( const SSspFrame& frame ) {
+            if( frame.Address() != m_nAddress || frame.length < 6 ) {
+                return;
+            }
+            const uint8_t nCommand = frame.data[ 3 ];
+            static const uint8_t POLL_REPLY[] = { SSP_RESPONSE_OK, SSP_POLL_CREDIT, SSP_STX, SSP_POLL_DISABLED };
+            static const uint8_t SERIAL_REPLY[] = { SSP_RESPONSE_OK, 0x00, 0x12, 0x34, 0x56 };
+            static const uint8_t OK_REPLY[] = { SSP_RESPONSE_OK };
+            const uint8_t* pReply = OK_REPLY;
+            uint8_t nLength = sizeof( OK_REPLY );
+            if( nCommand == SSP_CMD_POLL ) {
+                pReply = POLL_REPLY;
+                nLength = sizeof( POLL_REPLY );
+            } else if( nCommand == SSP_CMD_SERIAL_NUMBER ) {
+                pReply = SERIAL_REPLY;
+                nLength = sizeof( SERIAL_REPLY );
+            }
+
+            // The reply carries the SEQ bit of the command
+            CSSPFrameEncoder encoder( frame.data[ 1 ], pReply, nLength );
+            uint8_t txData[ 32 ];
+            const size_t nSize = encoder.Encode( txData, sizeof( txData ) );
+            if( ::write( m_nMaster, txData, nSize ) < 0 ) {
+                ::_exit( 0 );
+            }
+        } );
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+// SSP device on a pty for the benchmarks. The device runs in a forked process, so its CPU time and its context
+// switches are not counted with the library's. It answers every frame addressed to it:
+//   POLL           F0 EE 7F E8: a credit on channel 0x7F, stuffed on the wire
+//   SERIAL NUMBER  F0 00 12 34 56
+//   anything else  F0
+class CPtyDeviceEmulator {
+public:
+    explicit CPtyDeviceEmulator( uint8_t nAddress = 0 );
+    ~CPtyDeviceEmulator();
+
+    CPtyDeviceEmulator( const CPtyDeviceEmulator& ) = delete;
+    CPtyDeviceEmulator& operator=( const CPtyDeviceEmulator& ) = delete;
+
+    // Forks the device process. Call it before the library starts any thread
+    bool Start();
+    // The port to open
+    const std::string& GetSlaveName() const { return m_strSlaveName; }
+
+private:
+    void _run();
+
+    uint8_t m_nAddress;
+    int m_nMaster{ -1 };
+    std::string m_strSlaveName;
+    pid_t m_nPid{ -1 };
+};
@@ -0,0 +1,60 @@
+// CRC-16 throughput of every engine at the SSP packet sizes (a short command, a typical reply, the largest packet)
+// and over a 64 KiB buffer.
+// Usage: bench_crc16 [MiB per measurement]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "Crc16.h"
+
+namespace {
+    using namespace std::chrono;
+
+    const char* _engine_name( CCrc16::EEngine eEngine )
+    {
+        switch( eEngine ) {
+            case CCrc16::EEngine::Bitwise: return "bitwise";
+            case CCrc16::EEngine::Table: return "table";
+            case CCrc16::EEngine::SliceBy8: return "slice-by-8";
+            case CCrc16::EEngine::Clmul: return "clmul";
+        }
+        return "?";
+    }
+}
+
+int main( int argc, char** argv )
+{
+    const size_t nBytesPerRun = ( argc > 1 ? std::strtoul( argv[ 1 ], nullptr, 10 ) : 64 ) << 20;
+
+    std::vector< uint8_t > vData( 64 * 1024 );
+    std::mt19937 rng( 1 );
+    for( auto& b : vData ) {
+        b = static_cast< uint8_t >( rng() );
+    }
+
+    std::printf( "%-12s %8s %12s %12s\n", "engine", "bytes", "ns/call", "MB/s" );
+    for( auto eEngine : { CCrc16::EEngine::Bitwise, CCrc16::EEngine::Table, CCrc16::EEngine::SliceBy8, CCrc16::EEngine::Clmul } ) {
+        if( !CCrc16::IsSupported( eEngine ) ) {
+            std::printf( "%-12s not supported by the CPU\n", _engine_name( eEngine ) );
+            continue;
+        }
+
+        for( size_t nSize : { size_t{ 6 }, size_t{ 64 }, size_t{ 255 }, vData.size() } ) {
+            const size_t nCalls = std::max< size_t >( nBytesPerRun / nSize, 1 );
+
+            // Every call is seeded with the previous result so none of them can be dropped or overlapped
+            uint16_t nCrc{ 0xFFFF };
+            const auto tStart = steady_clock::now();
+            for( size_t i = 0; i < nCalls; ++i ) {
+                nCrc = CCrc16::Compute( eEngine, vData.data(), nSize, nCrc );
+            }
+            const double dSeconds = duration< double >( steady_clock::now() - tStart ).count();
+
+            std::printf( "%-12s %8zu %12.1f %12.1f   (crc %04X)\n", _engine_name( eEngine ), nSize, dSeconds * 1e9 / nCalls,
+                         nCalls * nSize / dSeconds / 1e6, nCrc );
+        }
+    }
+    return 0;
+}
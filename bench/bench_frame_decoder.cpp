@@ -0,0 +1,116 @@
+// Reply decoding throughput: the byte by byte SSPDataIn() against CSSPFrameDecoder::Feed() on the same 1 MiB stream of
+// poll replies (1-60 data bytes, STX stuffing included), clean and with noise between the frames, in 64 and 4096 byte reads.
+// Usage: bench_frame_decoder [passes]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "ITLSSPProc.h"
+#include "SSPFrameDecoder.h"
+#include "SSPFrameEncoder.h"
+#include "ssp_defines.h"
+
+namespace {
+    using namespace std::chrono;
+
+    const size_t STREAM_SIZE = 1 << 20;
+
+    // Replies for address 0 with the sequence bit toggling. The noise is 1-8 bytes of line garbage without STX
+    // before every frame, so both decoders see the same frames
+    std::vector< uint8_t > _poll_replies( bool bNoise, size_t& nFrames )
+    {
+        std::mt19937 rng( 1 );
+        std::vector< uint8_t > vStream;
+        nFrames = 0;
+        uint8_t data[ 60 ];
+        uint8_t frame[ 2 * sizeof( data ) + 8 ];
+        while( vStream.size() < STREAM_SIZE ) {
+            if( bNoise ) {
+                for( size_t n = 1 + rng() % 8; n > 0; --n ) {
+                    uint8_t b = static_cast< uint8_t >( rng() );
+                    vStream.push_back( b == SSP_STX ? 0 : b );
+                }
+            }
+            const uint8_t nLength = static_cast< uint8_t >( 1 + rng() % sizeof( data ) );
+            data[ 0 ] = SSP_RESPONSE_OK;
+            for( uint8_t i = 1; i < nLength; ++i ) {
+                data[ i ] = static_cast< uint8_t >( rng() );
+            }
+            CSSPFrameEncoder encoder( ( nFrames & 1 ) ? 0x80 : 0x00, data, nLength );
+            const size_t nSize = encoder.Encode( frame, sizeof( frame ) );
+            vStream.insert( vStream.end(), frame, frame + nSize );
+            ++nFrames;
+        }
+        return vStream;
+    }
+
+    size_t _run_data_in( const std::vector< uint8_t >& vStream, size_t nChunk )
+    {
+        SSP_TX_RX_PACKET ss{};
+        ss.SSPAddress = 0;
+        size_t nFrames{ 0 };
+        for( size_t i = 0; i < vStream.size(); i += nChunk ) {
+            const size_t nEnd = std::min( i + nChunk, vStream.size() );
+            for( size_t j = i; j < nEnd; ++j ) {
+                SSPDataIn( vStream[ j ], &ss );
+                if( ss.NewResponse ) {
+                    ss.NewResponse = 0;
+                    ++nFrames;
+                }
+            }
+        }
+        return nFrames;
+    }
+
+    size_t _run_feed( const std::vector< uint8_t >& vStream, size_t nChunk )
+    {
+        CSSPFrameDecoder decoder;
+        size_t nFrames{ 0 };
+        const CSSPFrameDecoder::frame_handler_t fnFrame = [ &nFrames ]( const SSspFrame& ) { ++nFrames; };
+        for( size_t i = 0; i < vStream.size(); i += nChunk ) {
+            decoder.Feed( vStream.data() + i, std::min( nChunk, vStream.size() - i ), fnFrame );
+        }
+        return nFrames;
+    }
+
+    // Best of the passes, in MB/s. nFrames gets the frames found by the last pass
+    double _measure( size_t ( *fnRun )( const std::vector< uint8_t >&, size_t ), const std::vector< uint8_t >& vStream,
+                     size_t nChunk, int nPasses, size_t& nFrames )
+    {
+        double dBest{ 0 };
+        for( int i = 0; i < nPasses; ++i ) {
+            const auto tStart = steady_clock::now();
+            nFrames = fnRun( vStream, nChunk );
+            const double dSeconds = duration< double >( steady_clock::now() - tStart ).count();
+            dBest = std::max( dBest, vStream.size() / dSeconds / 1e6 );
+        }
+        return dBest;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    const int nPasses = argc > 1 ? std::atoi( argv[ 1 ] ) : 20;
+
+    std::printf( "%-8s %6s %8s %16s %16s\n", "stream", "read", "frames", "SSPDataIn MB/s", "Feed() MB/s" );
+    for( bool bNoise : { false, true } ) {
+        size_t nFrames{ 0 };
+        const std::vector< uint8_t > vStream = _poll_replies( bNoise, nFrames );
+
+        for( size_t nChunk : { size_t{ 64 }, size_t{ 4096 } } ) {
+            size_t nDataInFrames{ 0 };
+            size_t nFeedFrames{ 0 };
+            const double dDataIn = _measure( _run_data_in, vStream, nChunk, nPasses, nDataInFrames );
+            const double dFeed = _measure( _run_feed, vStream, nChunk, nPasses, nFeedFrames );
+
+            std::printf( "%-8s %6zu %8zu %16.1f %16.1f", bNoise ? "noise" : "clean", nChunk, nFrames, dDataIn, dFeed );
+            if( nDataInFrames != nFrames || nFeedFrames != nFrames ) {
+                std::printf( "   frames found: SSPDataIn %zu, Feed() %zu", nDataInFrames, nFeedFrames );
+            }
+            std::printf( "\n" );
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,84 @@
+// CPU time and context switches of the library per poll: a POLL written with Write() and its reply awaited with
+// WaitForFrame(), against the pty device. The device process is not counted. For the system calls per poll run it
+// under strace -f -c with 0 polls and with N, and take the difference.
+// Usage: bench_poll_cost [asio|epoll|uring] [polls]
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/resource.h>
+#include "Bench.h"
+#include "DeviceEmulator.h"
+#include "SSPFrameEncoder.h"
+#include "ThreadedSerialPort.h"
+#include "ssp_defines.h"
+
+namespace {
+    // Polls run first, not measured
+    const int WARMUP_POLLS = 20;
+
+    double _cpu_us( const rusage& usage )
+    {
+        return ( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec ) * 1e6 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+    }
+}
+
+int main( int argc, char** argv )
+{
+    const char* szBackend = argc > 1 ? argv[ 1 ] : "asio";
+    if( !SelectSerialBackend( szBackend ) ) {
+        std::fprintf( stderr, "unknown backend %s\n", szBackend );
+        return 1;
+    }
+    const int nPolls = argc > 2 ? std::atoi( argv[ 2 ] ) : 1000;
+
+    CPtyDeviceEmulator device;
+    if( !device.Start() ) {
+        std::fprintf( stderr, "no pty\n" );
+        return 1;
+    }
+
+    CThreadedSerialPort port( device.GetSlaveName(), 9600, boost::asio::serial_port_base::parity::none, 8,
+                              boost::asio::serial_port_base::stop_bits::two );
+    if( !port.Open( false ) ) {
+        std::fprintf( stderr, "cannot open %s\n", device.GetSlaveName().c_str() );
+        return 1;
+    }
+    port.EnableFrameDecoding( true );
+    port.StartThread( false );
+
+    const uint8_t command = SSP_CMD_POLL;
+    uint8_t request[ 16 ];
+    const size_t nRequestSize = CSSPFrameEncoder( 0, &command, 1 ).Encode( request, sizeof( request ) );
+    const auto fnPoll = [ & ] {
+        SSspFrame frame;
+        boost::system::error_code ec;
+        return port.Write( request, nRequestSize )
+            && port.WaitForFrame( 0, std::chrono::steady_clock::now() + std::chrono::seconds( 1 ), frame, ec );
+    };
+
+    for( int i = 0; i < WARMUP_POLLS; ++i ) {
+        fnPoll();
+    }
+
+    rusage usage0, usage1;
+    ::getrusage( RUSAGE_SELF, &usage0 );
+    const auto t0 = std::chrono::steady_clock::now();
+    int nReplies{ 0 };
+    for( int i = 0; i < nPolls; ++i ) {
+        nReplies += fnPoll();
+    }
+    const auto t1 = std::chrono::steady_clock::now();
+    ::getrusage( RUSAGE_SELF, &usage1 );
+
+    if( nPolls > 0 ) {
+        std::printf( "%s: replies %d/%d  CPU %.1f ms per 1000 polls  wall %.1f ms per 1000 polls  "
+                     "voluntary ctx switches %.2f  involuntary %.2f per poll\n",
+                     DescribeSerialBackend(), nReplies, nPolls, ( _cpu_us( usage1 ) - _cpu_us( usage0 ) ) / nPolls,
+                     std::chrono::duration_cast< std::chrono::microseconds >( t1 - t0 ).count() / static_cast< double >( nPolls ),
+                     static_cast< double >( usage1.ru_nvcsw - usage0.ru_nvcsw ) / nPolls,
+                     static_cast< double >( usage1.ru_nivcsw - usage0.ru_nivcsw ) / nPolls );
+    }
+
+    port.StopThread();
+    return nReplies == nPolls ? 0 : 1;
+}
@@ -0,0 +1,55 @@
+// Read completions per reply on a live port: SYNC, SERIAL NUMBER and POLLs through the SSP API
+// against the pty device. Usage: bench_read_completions [asio|epoll|uring] [polls]
+#include <cstdio>
+#include <cstdlib>
+#include "Bench.h"
+#include "DeviceEmulator.h"
+#include "SSPComs.h"
+#include "ThreadedSerialPort.h"
+
+int main( int argc, char** argv )
+{
+    if( !SelectSerialBackend( argc > 1 ? argv[ 1 ] : nullptr ) ) {
+        std::fprintf( stderr, "unknown backend %s\n", argv[ 1 ] );
+        return 1;
+    }
+    const int nPolls = argc > 2 ? std::atoi( argv[ 2 ] ) : 5;
+
+    CPtyDeviceEmulator device;
+    if( !device.Start() ) {
+        std::fprintf( stderr, "no pty\n" );
+        return 1;
+    }
+
+    SSP_PORT port = OpenSSPPort( device.GetSlaveName().c_str() );
+    if( !port ) {
+        std::fprintf( stderr, "cannot open %s\n", device.GetSlaveName().c_str() );
+        return 1;
+    }
+
+    SSP_COMMAND_SETUP setup{};
+    setup.port = port;
+    setup.SSPAddress = 0;
+    setup.Timeout = 1000;
+    setup.RetryLevel = 2;
+    setup.EncryptionStatus = NO_ENCRYPTION;
+
+    int nReplies{ 0 };
+    nReplies += ssp_sync( setup ) == SSP_RESPONSE_OK;
+    unsigned long nSerial{ 0 };
+    nReplies += ssp_get_serial( setup, &nSerial ) == SSP_RESPONSE_OK;
+    for( int i = 0; i < nPolls; ++i ) {
+        SSP_POLL_DATA pollData{};
+        nReplies += ssp_poll( setup, &pollData ) == SSP_RESPONSE_OK;
+    }
+
+    const auto stats = port->GetRxStatistics();
+    std::printf( "%s: replies %d/%d  read completions %llu  bytes %llu  completions per reply %.2f  overflow %llu\n",
+                 DescribeSerialBackend(), nReplies, nPolls + 2, static_cast< unsigned long long >( stats.nReadCompletions ),
+                 static_cast< unsigned long long >( stats.nBytesReceived ),
+                 nReplies ? static_cast< double >( stats.nReadCompletions ) / nReplies : 0.0,
+                 static_cast< unsigned long long >( stats.nOverflowBytes ) );
+
+    CloseSSPPort( port );
+    return nReplies == nPolls + 2 ? 0 : 1;
+}
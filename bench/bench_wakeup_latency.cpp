@@ -0,0 +1,129 @@
+// Reader to waiter handoff latency: a peer thread writes a 6 byte frame 200 us after the waiter blocks, the time from
+// the write to the wait returning is sampled, over the in-memory transport and a pty, in frame and byte mode.
+// Usage: bench_wakeup_latency [samples]
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "MemoryTransport.h"
+#include "PtyTransport.h"
+#include "SerialPortManager.h"
+#include "ThreadedSerialPort.h"
+
+namespace {
+    using namespace std::chrono;
+
+    // A POLL for address 0
+    const uint8_t FRAME[] = { 0x7F, 0x80, 0x01, 0x07, 0x12, 0x02 };
+    // Samples dropped while the caches and the scheduler settle
+    const int WARMUP_SAMPLES = 100;
+
+    void _measure( const char* szName, CThreadedSerialPort& port, const std::function< void() >& fnSend, bool bFrames, int nSamples )
+    {
+        port.EnableFrameDecoding( bFrames );
+        const auto wakeups0 = port.GetWakeupStatistics();
+
+        std::vector< double > vLatencies;
+        int nFailed{ 0 };
+        for( int i = 0; i < WARMUP_SAMPLES + nSamples; ++i ) {
+            steady_clock::time_point tSent;
+            std::thread peer( [ & ] {
+                std::this_thread::sleep_for( microseconds( 200 ) );
+                tSent = steady_clock::now();
+                fnSend();
+            } );
+
+            boost::system::error_code ec;
+            bool bReceived;
+            if( bFrames ) {
+                SSspFrame frame;
+                bReceived = port.WaitForFrame( CThreadedSerialPort::ANY_ADDRESS, steady_clock::now() + seconds( 1 ), frame, ec );
+            } else {
+                uint8_t data[ sizeof( FRAME ) ];
+                bReceived = port.WaitForIncomingData( data, sizeof( data ), 1000, ec ) == sizeof( data );
+            }
+            const auto tReturned = steady_clock::now();
+            peer.join();
+
+            if( !bReceived ) {
+                ++nFailed;
+            } else if( i >= WARMUP_SAMPLES ) {
+                vLatencies.push_back( duration_cast< nanoseconds >( tReturned - tSent ).count() / 1000.0 );
+            }
+        }
+
+        if( vLatencies.empty() ) {
+            std::printf( "%-10s no samples, %d failed\n", szName, nFailed );
+            return;
+        }
+        std::sort( vLatencies.begin(), vLatencies.end() );
+        const auto wakeups1 = port.GetWakeupStatistics();
+        const uint64_t nWakeups = wakeups1.nWakeups - wakeups0.nWakeups;
+        std::printf( "%-10s write to return p50 %.1f us  p90 %.1f us  p99 %.1f us  |  notify to running mean %.1f us (%llu)  failed %d\n",
+                     szName, vLatencies[ vLatencies.size() / 2 ], vLatencies[ vLatencies.size() * 9 / 10 ],
+                     vLatencies[ vLatencies.size() * 99 / 100 ],
+                     nWakeups ? ( wakeups1.nTotalNs - wakeups0.nTotalNs ) / 1000.0 / nWakeups : 0.0,
+                     static_cast< unsigned long long >( nWakeups ), nFailed );
+    }
+}
+
+int main( int argc, char** argv )
+{
+    const int nSamples = argc > 1 ? std::atoi( argv[ 1 ] ) : 2900;
+    auto& io_service = CSerialPortManager::Instance().GetIoService();
+
+    {
+        auto pair = CMemoryTransport::CreatePair( io_service );
+        CMemoryTransport* pPeer = pair.second.get();
+        CThreadedSerialPort port( std::move( pair.first ) );
+        boost::system::error_code ec;
+        pPeer->Open( "", ec );
+        if( ec || !port.Open( false ) ) {
+            std::fprintf( stderr, "cannot open the memory transport\n" );
+            return 1;
+        }
+        port.StartThread( false );
+        const auto fnSend = [ pPeer ] {
+            boost::asio::const_buffer buffer( FRAME, sizeof( FRAME ) );
+            boost::system::error_code error;
+            pPeer->Write( &buffer, 1, error );
+        };
+        _measure( "mem frame", port, fnSend, true, nSamples );
+        _measure( "mem bytes", port, fnSend, false, nSamples );
+        port.StopThread();
+    }
+
+    {
+        std::unique_ptr< CPtyTransport > pTransport( new CPtyTransport( io_service ) );
+        // The pty is created when the port opens
+        CPtyTransport* pPty = pTransport.get();
+        CThreadedSerialPort port( std::move( pTransport ) );
+        const int nSlave = port.Open( false ) ? ::open( pPty->GetSlaveName().c_str(), O_RDWR | O_NOCTTY ) : -1;
+        if( nSlave < 0 ) {
+            std::fprintf( stderr, "cannot open a pty\n" );
+            return 1;
+        }
+        termios tio{};
+        ::tcgetattr( nSlave, &tio );
+        ::cfmakeraw( &tio );
+        ::tcsetattr( nSlave, TCSANOW, &tio );
+        port.StartThread( false );
+        const auto fnSend = [ nSlave ] {
+            if( ::write( nSlave, FRAME, sizeof( FRAME ) ) < 0 ) {
+                std::perror( "write" );
+            }
+        };
+        _measure( "pty frame", port, fnSend, true, nSamples );
+        _measure( "pty bytes", port, fnSend, false, nSamples );
+        port.StopThread();
+        ::close( nSlave );
+    }
+
+    return 0;
+}
@@ -0,0 +1,266 @@
+#include "Crc16.h"
+#include <array>
+
+#if defined( __x86_64__ )
+#include <immintrin.h>
+#elif defined( __aarch64__ )
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace {
+    // Below this the folding setup costs more than it saves
+    const size_t CLMUL_MIN_SIZE = 64;
+
+    using table_t = std::array< uint16_t, 256 >;
+
+    // T[ 0 ][ b ]: the CRC of the byte b with a zero seed. T[ k ][ b ]: the same followed by k zero bytes
+    constexpr std::array< table_t, 8 > _make_tables()
+    {
+        std::array< table_t, 8 > tables{};
+        for( uint32_t b = 0; b < 256; ++b ) {
+            uint16_t crc = static_cast< uint16_t >( b << 8 );
+            for( int j = 0; j < 8; ++j ) {
+                crc = static_cast< uint16_t >( ( crc & 0x8000 ) ? ( crc << 1 ) ^ CCrc16::POLY : crc << 1 );
+            }
+            tables[ 0 ][ b ] = crc;
+        }
+        for( size_t k = 1; k < 8; ++k ) {
+            for( uint32_t b = 0; b < 256; ++b ) {
+                const uint16_t crc = tables[ k - 1 ][ b ];
+                tables[ k ][ b ] = static_cast< uint16_t >( ( crc << 8 ) ^ tables[ 0 ][ crc >> 8 ] );
+            }
+        }
+        return tables;
+    }
+
+    constexpr std::array< table_t, 8 > g_tables = _make_tables();
+    static_assert( g_tables[ 0 ][ 1 ] == CCrc16::POLY, "CRC table generation" );
+
+    uint16_t _crc_bitwise( const uint8_t* p, size_t n, uint16_t crc )
+    {
+        for( size_t i = 0; i < n; ++i ) {
+            crc ^= static_cast< uint16_t >( p[ i ] << 8 );
+            for( int j = 0; j < 8; ++j ) {
+                crc = static_cast< uint16_t >( ( crc & 0x8000 ) ? ( crc << 1 ) ^ CCrc16::POLY : crc << 1 );
+            }
+        }
+        return crc;
+    }
+
+    uint16_t _crc_table( const uint8_t* p, size_t n, uint16_t crc )
+    {
+        for( size_t i = 0; i < n; ++i ) {
+            crc = static_cast< uint16_t >( ( crc << 8 ) ^ g_tables[ 0 ][ ( crc >> 8 ) ^ p[ i ] ] );
+        }
+        return crc;
+    }
+
+    uint16_t _crc_slice_by_8( const uint8_t* p, size_t n, uint16_t crc )
+    {
+        // The CRC goes into the first two bytes, every byte then contributes its remainder from its distance to the end
+        for( ; n >= 8; p += 8, n -= 8 ) {
+            crc = g_tables[ 7 ][ p[ 0 ] ^ ( crc >> 8 ) ] ^ g_tables[ 6 ][ p[ 1 ] ^ ( crc & 0xFF ) ]
+                ^ g_tables[ 5 ][ p[ 2 ] ] ^ g_tables[ 4 ][ p[ 3 ] ]
+                ^ g_tables[ 3 ][ p[ 4 ] ] ^ g_tables[ 2 ][ p[ 5 ] ]
+                ^ g_tables[ 1 ][ p[ 6 ] ] ^ g_tables[ 0 ][ p[ 7 ] ];
+        }
+        return _crc_table( p, n, crc );
+    }
+
+    // x^n mod P, the folding distances
+    constexpr uint64_t _xpow_mod( uint32_t n )
+    {
+        uint32_t r = 1;
+        for( uint32_t i = 0; i < n; ++i ) {
+            r = ( r & 0x8000 ) ? ( ( r << 1 ) ^ CCrc16::POLY ) & 0xFFFF : r << 1;
+        }
+        return r;
+    }
+
+    // The folding: with the message as a polynomial (first byte highest), CRC = ( seed * x^8n + M * x^16 ) mod P,
+    // and the seed term is the seed xored into the first two bytes. A 128-bit accumulator X = H * x^64 + L
+    // moved forward by d bits is H * ( x^(d+64) mod P ) + L * ( x^d mod P ): two 64x16 bit products, under 80 bits.
+    // Four accumulators 512 bits apart hide the multiplier latency. The result is reduced to 64 bits the same way
+    // and its top 48 bits are finished through the table, since M * x^16 mod P is the CRC of M with a zero seed
+    constexpr uint64_t K_512_HI = _xpow_mod( 512 + 64 );
+    constexpr uint64_t K_512_LO = _xpow_mod( 512 );
+    constexpr uint64_t K_128_HI = _xpow_mod( 128 + 64 );
+    constexpr uint64_t K_128_LO = _xpow_mod( 128 );
+    constexpr uint64_t K_80 = _xpow_mod( 80 );
+    constexpr uint64_t K_64 = _xpow_mod( 64 );
+
+    uint16_t _finish( uint64_t u )
+    {
+        const uint8_t bytes[ 6 ] = {
+            static_cast< uint8_t >( u >> 56 ), static_cast< uint8_t >( u >> 48 ), static_cast< uint8_t >( u >> 40 ),
+            static_cast< uint8_t >( u >> 32 ), static_cast< uint8_t >( u >> 24 ), static_cast< uint8_t >( u >> 16 )
+        };
+        return static_cast< uint16_t >( _crc_table( bytes, sizeof( bytes ), 0 ) ^ ( u & 0xFFFF ) );
+    }
+
+#if defined( __x86_64__ )
+
+    bool _has_clmul()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports( "pclmul" ) && __builtin_cpu_supports( "ssse3" );
+    }
+
+    __attribute__(( target( "pclmul,ssse3" ) ))
+    inline __m128i _load( const uint8_t* p )
+    {
+        const __m128i reverse = _mm_setr_epi8( 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 );
+        return _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) ), reverse );
+    }
+
+    __attribute__(( target( "pclmul,ssse3" ) ))
+    inline __m128i _fold( __m128i x, __m128i k )
+    {
+        return _mm_xor_si128( _mm_clmulepi64_si128( x, k, 0x11 ), _mm_clmulepi64_si128( x, k, 0x00 ) );
+    }
+
+    // Whole 16 byte blocks only, nSize >= 64. Returns the CRC after them
+    __attribute__(( target( "pclmul,ssse3" ) ))
+    uint16_t _crc_clmul_blocks( const uint8_t* p, size_t n, uint16_t crc )
+    {
+        const __m128i k512 = _mm_set_epi64x( K_512_HI, K_512_LO );
+        const __m128i k128 = _mm_set_epi64x( K_128_HI, K_128_LO );
+
+        __m128i x0 = _mm_xor_si128( _load( p ), _mm_set_epi64x( static_cast< int64_t >( static_cast< uint64_t >( crc ) << 48 ), 0 ) );
+        __m128i x1 = _load( p + 16 );
+        __m128i x2 = _load( p + 32 );
+        __m128i x3 = _load( p + 48 );
+        for( p += 64, n -= 64; n >= 64; p += 64, n -= 64 ) {
+            x0 = _mm_xor_si128( _fold( x0, k512 ), _load( p ) );
+            x1 = _mm_xor_si128( _fold( x1, k512 ), _load( p + 16 ) );
+            x2 = _mm_xor_si128( _fold( x2, k512 ), _load( p + 32 ) );
+            x3 = _mm_xor_si128( _fold( x3, k512 ), _load( p + 48 ) );
+        }
+        __m128i x = _mm_xor_si128( _fold( x0, k128 ), x1 );
+        x = _mm_xor_si128( _fold( x, k128 ), x2 );
+        x = _mm_xor_si128( _fold( x, k128 ), x3 );
+        for( ; n >= 16; p += 16, n -= 16 ) {
+            x = _mm_xor_si128( _fold( x, k128 ), _load( p ) );
+        }
+
+        // X * x^16 = H * x^80 + L * x^16, under 80 bits, then its top 16 bits moved down by x^64
+        const __m128i kReduce = _mm_set_epi64x( K_64, K_80 );
+        const __m128i t = _mm_xor_si128( _mm_clmulepi64_si128( x, kReduce, 0x01 ), _mm_slli_si128( _mm_move_epi64( x ), 2 ) );
+        const uint64_t u = static_cast< uint64_t >( _mm_cvtsi128_si64( _mm_clmulepi64_si128( t, kReduce, 0x11 ) ) )
+                         ^ static_cast< uint64_t >( _mm_cvtsi128_si64( t ) );
+        return _finish( u );
+    }
+
+#elif defined( __aarch64__ )
+
+    bool _has_clmul()
+    {
+        return ( getauxval( AT_HWCAP ) & HWCAP_PMULL ) != 0;
+    }
+
+    __attribute__(( target( "+crypto" ) ))
+    inline uint64x2_t _load( const uint8_t* p )
+    {
+        // Byte reversed within the halves, then the halves swapped: lane 1 holds the first 8 bytes
+        const uint64x2_t v = vreinterpretq_u64_u8( vrev64q_u8( vld1q_u8( p ) ) );
+        return vextq_u64( v, v, 1 );
+    }
+
+    __attribute__(( target( "+crypto" ) ))
+    inline uint64x2_t _clmul( uint64_t a, uint64_t b )
+    {
+        return vreinterpretq_u64_p128( vmull_p64( static_cast< poly64_t >( a ), static_cast< poly64_t >( b ) ) );
+    }
+
+    __attribute__(( target( "+crypto" ) ))
+    inline uint64x2_t _fold( uint64x2_t x, uint64_t kHi, uint64_t kLo )
+    {
+        return veorq_u64( _clmul( vgetq_lane_u64( x, 1 ), kHi ), _clmul( vgetq_lane_u64( x, 0 ), kLo ) );
+    }
+
+    // Whole 16 byte blocks only, nSize >= 64. Returns the CRC after them
+    __attribute__(( target( "+crypto" ) ))
+    uint16_t _crc_clmul_blocks( const uint8_t* p, size_t n, uint16_t crc )
+    {
+        uint64x2_t x0 = veorq_u64( _load( p ), vcombine_u64( vcreate_u64( 0 ), vcreate_u64( static_cast< uint64_t >( crc ) << 48 ) ) );
+        uint64x2_t x1 = _load( p + 16 );
+        uint64x2_t x2 = _load( p + 32 );
+        uint64x2_t x3 = _load( p + 48 );
+        for( p += 64, n -= 64; n >= 64; p += 64, n -= 64 ) {
+            x0 = veorq_u64( _fold( x0, K_512_HI, K_512_LO ), _load( p ) );
+            x1 = veorq_u64( _fold( x1, K_512_HI, K_512_LO ), _load( p + 16 ) );
+            x2 = veorq_u64( _fold( x2, K_512_HI, K_512_LO ), _load( p + 32 ) );
+            x3 = veorq_u64( _fold( x3, K_512_HI, K_512_LO ), _load( p + 48 ) );
+        }
+        uint64x2_t x = veorq_u64( _fold( x0, K_128_HI, K_128_LO ), x1 );
+        x = veorq_u64( _fold( x, K_128_HI, K_128_LO ), x2 );
+        x = veorq_u64( _fold( x, K_128_HI, K_128_LO ), x3 );
+        for( ; n >= 16; p += 16, n -= 16 ) {
+            x = veorq_u64( _fold( x, K_128_HI, K_128_LO ), _load( p ) );
+        }
+
+        // X * x^16 = H * x^80 + L * x^16, under 80 bits, then its top 16 bits moved down by x^64
+        const uint64_t l = vgetq_lane_u64( x, 0 );
+        const uint64x2_t t = veorq_u64( _clmul( vgetq_lane_u64( x, 1 ), K_80 ), vcombine_u64( vcreate_u64( l << 16 ), vcreate_u64( l >> 48 ) ) );
+        const uint64_t u = vgetq_lane_u64( _clmul( vgetq_lane_u64( t, 1 ), K_64 ), 0 ) ^ vgetq_lane_u64( t, 0 );
+        return _finish( u );
+    }
+
+#else
+
+    bool _has_clmul()
+    {
+        return false;
+    }
+
+    uint16_t _crc_clmul_blocks( const uint8_t* p, size_t n, uint16_t crc )
+    {
+        return _crc_slice_by_8( p, n & ~static_cast< size_t >( 15 ), crc );
+    }
+
+#endif
+
+    const bool g_bHasClmul = _has_clmul();
+
+    uint16_t _crc_clmul( const uint8_t* p, size_t n, uint16_t crc )
+    {
+        if( n < 64 ) {
+            return _crc_slice_by_8( p, n, crc );
+        }
+        const size_t nBlocks = n & ~static_cast< size_t >( 15 );
+        return _crc_slice_by_8( p + nBlocks, n - nBlocks, _crc_clmul_blocks( p, nBlocks, crc ) );
+    }
+}
+
+uint16_t CCrc16::Compute( const uint8_t* pData, size_t nSize, uint16_t nSeed )
+{
+    if( nSize >= CLMUL_MIN_SIZE && g_bHasClmul ) {
+        return _crc_clmul( pData, nSize, nSeed );
+    }
+    return _crc_slice_by_8( pData, nSize, nSeed );
+}
+
+uint16_t CCrc16::Compute( EEngine eEngine, const uint8_t* pData, size_t nSize, uint16_t nSeed )
+{
+    switch( eEngine ) {
+    case EEngine::Bitwise:
+        return _crc_bitwise( pData, nSize, nSeed );
+    case EEngine::Table:
+        return _crc_table( pData, nSize, nSeed );
+    case EEngine::Clmul:
+        if( g_bHasClmul ) {
+            return _crc_clmul( pData, nSize, nSeed );
+        }
+        break;
+    case EEngine::SliceBy8:
+        break;
+    }
+    return _crc_slice_by_8( pData, nSize, nSeed );
+}
+
+bool CCrc16::IsSupported( EEngine eEngine )
+{
+    return EEngine::Clmul != eEngine || g_bHasClmul;
+}
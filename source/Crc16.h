@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// The SSP CRC-16: polynomial 0x8005 processed MSB first, no reflection and no final xor. The frames use
+// the seed 0xFFFF. Bit-identical to the bitwise cal_crc_loop_CCITT_A(), which dispatches here for that polynomial
+class CCrc16 {
+public:
+    enum class EEngine {
+        Bitwise,        // the reference: 8 conditional shifts per byte
+        Table,          // one lookup per byte
+        SliceBy8,       // 8 tables, 8 bytes per lookup round
+        Clmul           // carry-less multiply folding, 64 bytes per round: PCLMULQDQ (x86-64), PMULL (AArch64)
+    };
+
+    static constexpr uint16_t POLY = 0x8005;
+
+    // The fastest engine the CPU has for the size: slicing-by-8 for the short frames, folding for the long buffers
+    static uint16_t Compute( const uint8_t* pData, size_t nSize, uint16_t nSeed );
+    // A given engine, for verification and benchmarks. An unsupported one falls back to SliceBy8
+    static uint16_t Compute( EEngine eEngine, const uint8_t* pData, size_t nSize, uint16_t nSeed );
+
+    // The CPU features are detected when the library loads
+    static bool IsSupported( EEngine eEngine );
+};
@@ -1,6 +1,7 @@
 ﻿#include "itl_types.h"
 #include <cstdlib>
 #include "Encryption.h"
+#include "Crc16.h"
 
 
 /***************************************************************************
@@ -666,6 +667,10 @@ extern UINT8 aes_decrypt( const UINT8   aes_mode,
 
 unsigned short cal_crc_loop_CCITT_A( short l, unsigned char* p, unsigned short seed,unsigned short cd )
 {
+	// The SSP polynomial has the table and folding engines
+	if ( cd == CCrc16::POLY )
+		return l > 0 ? CCrc16::Compute( p, static_cast< size_t >( l ), seed ) : seed;
+
 	int i, j;
 	unsigned short crc = seed;
 
@@ -0,0 +1,130 @@
+#include "EpollReactor.h"
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+    const int MAX_EVENTS = 64;
+}
+
+CEpollReactor& CEpollReactor::Instance()
+{
+    // Never destroyed: the transports may still be closed from the other singletons' destructors
+    static CEpollReactor* pReactor = new CEpollReactor;
+    return *pReactor;
+}
+
+CEpollReactor::CEpollReactor()
+    : m_epoll{ ::epoll_create1( EPOLL_CLOEXEC ) }
+    , m_wakeup{ ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC ) }
+{
+    if( m_epoll >= 0 && m_wakeup >= 0 ) {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = m_wakeup;
+        ::epoll_ctl( m_epoll, EPOLL_CTL_ADD, m_wakeup, &event );
+
+        m_thread = CLibraryThread( EThreadRole::Reactor, [ this ] { _fnRunner(); }, "-epoll" );
+    }
+}
+
+void CEpollReactor::Add( int fd, std::shared_ptr< IHandler > pHandler, boost::system::error_code& ec )
+{
+    if( m_epoll < 0 || m_wakeup < 0 ) {
+        ec = boost::system::error_code( EMFILE, boost::system::system_category() );
+        return;
+    }
+
+    std::lock_guard< std::mutex > _lck( m_mtx );
+    m_handlers[ fd ] = std::move( pHandler );
+
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    event.data.fd = fd;
+    if( ::epoll_ctl( m_epoll, EPOLL_CTL_ADD, fd, &event ) != 0 ) {
+        ec = boost::system::error_code( errno, boost::system::system_category() );
+        m_handlers.erase( fd );
+    }
+}
+
+void CEpollReactor::WatchOutput( int fd )
+{
+    epoll_event event{};
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = fd;
+    ::epoll_ctl( m_epoll, EPOLL_CTL_MOD, fd, &event );
+}
+
+void CEpollReactor::Remove( int fd )
+{
+    std::lock_guard< std::mutex > _lck( m_mtx );
+    ::epoll_ctl( m_epoll, EPOLL_CTL_DEL, fd, nullptr );
+    m_handlers.erase( fd );
+}
+
+void CEpollReactor::Post( std::function< void() > fn )
+{
+    {
+        std::lock_guard< std::mutex > _lck( m_mtx );
+        m_posted.push_back( std::move( fn ) );
+    }
+    const uint64_t nOne{ 1 };
+    ssize_t nResult;
+    do {
+        nResult = ::write( m_wakeup, &nOne, sizeof( nOne ) );
+    } while( nResult < 0 && errno == EINTR );
+}
+
+void CEpollReactor::_fnRunner()
+{
+    epoll_event events[ MAX_EVENTS ];
+
+    for( ; ; ) {
+        int nEvents = ::epoll_wait( m_epoll, events, MAX_EVENTS, -1 );
+        if( nEvents < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            return;
+        }
+
+        for( int i = 0; i < nEvents; ++i ) {
+            if( events[ i ].data.fd == m_wakeup ) {
+                _run_posted();
+                continue;
+            }
+
+            // The handler is called outside the lock: it completes operations whose handlers start new ones
+            std::shared_ptr< IHandler > pHandler;
+            {
+                std::lock_guard< std::mutex > _lck( m_mtx );
+                auto it = m_handlers.find( events[ i ].data.fd );
+                if( it != m_handlers.end() ) {
+                    pHandler = it->second;
+                }
+            }
+            if( pHandler ) {
+                pHandler->OnEvents( events[ i ].events );
+            }
+        }
+    }
+}
+
+void CEpollReactor::_run_posted()
+{
+    // Reading an eventfd resets its counter
+    uint64_t nCount;
+    if( ::read( m_wakeup, &nCount, sizeof( nCount ) ) < 0 ) {
+        nCount = 0;
+    }
+
+    std::vector< std::function< void() > > vPosted;
+    {
+        std::lock_guard< std::mutex > _lck( m_mtx );
+        vPosted.swap( m_posted );
+    }
+    for( auto& fn : vPosted ) {
+        fn();
+    }
+}
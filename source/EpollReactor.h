@@ -0,0 +1,54 @@
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <boost/system/error_code.hpp>
+#include "LibraryThread.h"
+
+// Native reactor of CEpollSerialTransport: one epoll set for all the registered descriptors, served by
+// one library thread (EThreadRole::Reactor, "ssp-io-epoll"). Other threads wake it through an eventfd.
+// Started on the first use and never stopped - the process exit takes the thread down
+class CEpollReactor {
+public:
+    // Called from the reactor thread with the epoll events of the descriptor
+    class IHandler {
+    public:
+        virtual ~IHandler() = default;
+        virtual void OnEvents( uint32_t nEvents ) = 0;
+    };
+
+    static CEpollReactor& Instance();
+
+    CEpollReactor( const CEpollReactor& ) = delete;
+    CEpollReactor& operator=( const CEpollReactor& ) = delete;
+
+    // Edge triggered input and hang-up events. The reactor keeps a reference to the handler
+    // until Remove(), a call of OnEvents() already in progress may outlive Remove() on that reference
+    void Add( int fd, std::shared_ptr< IHandler > pHandler, boost::system::error_code& ec );
+    // Output events too, from now on. Asked for by the first write which would block:
+    // until then every write would wake the reactor for nothing
+    void WatchOutput( int fd );
+    void Remove( int fd );
+
+    // Runs fn on the reactor thread, e.g. a completion which must not be called from the initiating function
+    void Post( std::function< void() > fn );
+
+private:
+    CEpollReactor();
+
+    void _fnRunner();
+    void _run_posted();
+
+private:
+    int m_epoll{ -1 };
+    int m_wakeup{ -1 };
+
+    std::mutex m_mtx;
+    std::map< int, std::shared_ptr< IHandler > > m_handlers;
+    std::vector< std::function< void() > > m_posted;
+
+    CLibraryThread m_thread;
+};
@@ -0,0 +1,332 @@
+#include "EpollSerialTransport.h"
+#include "TtyLine.h"
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+
+namespace {
+    // The blocking Write() rechecks the descriptor this often while the output queue is full
+    const int WRITE_POLL_MS = 100;
+
+    boost::system::error_code _errno_error()
+    {
+        return boost::system::error_code( errno, boost::system::system_category() );
+    }
+
+    // Drops the fully written buffers and trims the partially written one
+    void _consume( std::vector< boost::asio::const_buffer >& vBuffers, size_t nBytes )
+    {
+        size_t nDone{ 0 };
+        while( nDone < vBuffers.size() && nBytes >= vBuffers[ nDone ].size() ) {
+            nBytes -= vBuffers[ nDone ].size();
+            ++nDone;
+        }
+        vBuffers.erase( vBuffers.begin(), vBuffers.begin() + nDone );
+        if( nBytes > 0 && !vBuffers.empty() ) {
+            vBuffers.front() += nBytes;
+        }
+    }
+
+    ssize_t _writev( int fd, const std::vector< boost::asio::const_buffer >& vBuffers )
+    {
+        iovec iov[ IOV_MAX < 64 ? IOV_MAX : 64 ];
+        size_t nIov{ 0 };
+        for( ; nIov < vBuffers.size() && nIov < sizeof( iov ) / sizeof( iov[ 0 ] ); ++nIov ) {
+            iov[ nIov ].iov_base = const_cast< void* >( vBuffers[ nIov ].data() );
+            iov[ nIov ].iov_len = vBuffers[ nIov ].size();
+        }
+
+        ssize_t nResult;
+        do {
+            nResult = ::writev( fd, iov, static_cast< int >( nIov ) );
+        } while( nResult < 0 && errno == EINTR );
+        return nResult;
+    }
+}
+
+CEpollSerialTransport::CEpollSerialTransport( std::string strName )
+    : m_strName{ std::move( strName ) }
+    , m_channel{ std::make_shared< CChannel >() }
+{
+}
+
+CEpollSerialTransport::~CEpollSerialTransport()
+{
+    Close();
+}
+
+void CEpollSerialTransport::Open( const std::string& strDevicePath, boost::system::error_code& ec )
+{
+    std::lock_guard< std::mutex > _lck( m_channel->mtx );
+    if( m_channel->fd >= 0 ) {
+        ec = boost::asio::error::already_open;
+        return;
+    }
+
+    int fd = OpenRawTty( strDevicePath, false, ec );
+    if( fd < 0 ) {
+        return;
+    }
+
+    CEpollReactor::Instance().Add( fd, m_channel, ec );
+    if( ec ) {
+        ::close( fd );
+        return;
+    }
+    m_channel->fd = fd;
+    m_channel->bReadable = true;
+    m_channel->bWatchingOutput = false;
+}
+
+bool CEpollSerialTransport::IsOpen() const
+{
+    return m_channel->fd >= 0;
+}
+
+void CEpollSerialTransport::Close()
+{
+    io_handler_t fnRead, fnWrite;
+    {
+        std::unique_lock< std::mutex > _lck( m_channel->mtx );
+        const int fd = m_channel->fd;
+        if( fd < 0 ) {
+            return;
+        }
+        CEpollReactor::Instance().Remove( fd );
+        m_channel->fd = -1;
+
+        // A blocking writer notices the close within WRITE_POLL_MS
+        m_channel->cvWriters.wait( _lck, [ this ] { return 0 == m_channel->nWriters; } );
+        ::close( fd );
+
+        fnRead = std::move( m_channel->fnRead );
+        fnWrite = std::move( m_channel->fnWrite );
+        m_channel->fnRead = nullptr;
+        m_channel->fnWrite = nullptr;
+        m_channel->vWrite.clear();
+    }
+    _post( std::move( fnRead ), boost::asio::error::operation_aborted, 0 );
+    _post( std::move( fnWrite ), boost::asio::error::operation_aborted, 0 );
+}
+
+void CEpollSerialTransport::Cancel()
+{
+    io_handler_t fnRead, fnWrite;
+    {
+        std::lock_guard< std::mutex > _lck( m_channel->mtx );
+        fnRead = std::move( m_channel->fnRead );
+        fnWrite = std::move( m_channel->fnWrite );
+        m_channel->fnRead = nullptr;
+        m_channel->fnWrite = nullptr;
+        m_channel->vWrite.clear();
+    }
+    _post( std::move( fnRead ), boost::asio::error::operation_aborted, 0 );
+    _post( std::move( fnWrite ), boost::asio::error::operation_aborted, 0 );
+}
+
+void CEpollSerialTransport::SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec )
+{
+    std::lock_guard< std::mutex > _lck( m_channel->mtx );
+    const int fd = m_channel->fd;
+    if( fd < 0 ) {
+        ec = boost::asio::error::bad_descriptor;
+        return;
+    }
+
+    SetTtyLineSettings( fd, settings, ec );
+}
+
+void CEpollSerialTransport::AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler )
+{
+    std::unique_lock< std::mutex > _lck( m_channel->mtx );
+    if( m_channel->fd < 0 ) {
+        _lck.unlock();
+        _post( std::move( fnHandler ), boost::asio::error::bad_descriptor, 0 );
+        return;
+    }
+
+    m_channel->readBuffer = buffer;
+    m_channel->fnRead = std::move( fnHandler );
+
+    // Edge triggered: whatever arrived before the read was pending has to be taken now
+    if( m_channel->bReadable && m_channel->TryRead() ) {
+        io_handler_t fnRead = std::move( m_channel->fnRead );
+        m_channel->fnRead = nullptr;
+        auto ec = m_channel->readError;
+        auto nRead = m_channel->nRead;
+        _lck.unlock();
+        _post( std::move( fnRead ), ec, nRead );
+    }
+}
+
+void CEpollSerialTransport::AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler )
+{
+    std::unique_lock< std::mutex > _lck( m_channel->mtx );
+    if( m_channel->fd < 0 ) {
+        _lck.unlock();
+        _post( std::move( fnHandler ), boost::asio::error::bad_descriptor, 0 );
+        return;
+    }
+
+    m_channel->vWrite.assign( pBuffers, pBuffers + nBuffers );
+    m_channel->fnWrite = std::move( fnHandler );
+    m_channel->nWritten = 0;
+
+    if( m_channel->TryWrite() ) {
+        io_handler_t fnWrite = std::move( m_channel->fnWrite );
+        m_channel->fnWrite = nullptr;
+        auto ec = m_channel->writeError;
+        auto nWritten = m_channel->nWritten;
+        _lck.unlock();
+        _post( std::move( fnWrite ), ec, nWritten );
+    }
+}
+
+size_t CEpollSerialTransport::Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec )
+{
+    // Registered as a writer: Close() keeps the descriptor open until the write returns
+    int fd;
+    {
+        std::lock_guard< std::mutex > _lck( m_channel->mtx );
+        fd = m_channel->fd;
+        if( fd < 0 ) {
+            ec = boost::asio::error::bad_descriptor;
+            return 0;
+        }
+        ++m_channel->nWriters;
+    }
+
+    const size_t nTotal = _write_all( fd, pBuffers, nBuffers, ec );
+
+    {
+        std::lock_guard< std::mutex > _lck( m_channel->mtx );
+        --m_channel->nWriters;
+    }
+    m_channel->cvWriters.notify_all();
+    return nTotal;
+}
+
+size_t CEpollSerialTransport::_write_all( int fd, const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec )
+{
+    std::vector< boost::asio::const_buffer > vBuffers( pBuffers, pBuffers + nBuffers );
+    size_t nTotal{ 0 };
+    while( !vBuffers.empty() ) {
+        ssize_t nResult = _writev( fd, vBuffers );
+        if( nResult >= 0 ) {
+            nTotal += static_cast< size_t >( nResult );
+            _consume( vBuffers, static_cast< size_t >( nResult ) );
+            continue;
+        }
+        if( errno != EAGAIN ) {
+            ec = _errno_error();
+            return nTotal;
+        }
+
+        // The kernel output queue is full. Wait for room unless the port is being closed meanwhile
+        pollfd pfd{ fd, POLLOUT, 0 };
+        ::poll( &pfd, 1, WRITE_POLL_MS );
+        if( m_channel->fd != fd ) {
+            ec = boost::asio::error::operation_aborted;
+            return nTotal;
+        }
+    }
+    return nTotal;
+}
+
+int CEpollSerialTransport::GetTtyHandle()
+{
+    return m_channel->fd;
+}
+
+void CEpollSerialTransport::_post( io_handler_t fnHandler, const boost::system::error_code& ec, size_t nBytes )
+{
+    if( fnHandler ) {
+        CEpollReactor::Instance().Post( [ fnHandler, ec, nBytes ] { fnHandler( ec, nBytes ); } );
+    }
+}
+
+void CEpollSerialTransport::CChannel::OnEvents( uint32_t nEvents )
+{
+    io_handler_t fnReadDone, fnWriteDone;
+    boost::system::error_code readEc, writeEc;
+    size_t nReadDone{ 0 }, nWriteDone{ 0 };
+    {
+        std::lock_guard< std::mutex > _lck( mtx );
+        if( nEvents & ( EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR ) ) {
+            bReadable = true;
+        }
+        if( fnRead && bReadable && TryRead() ) {
+            fnReadDone = std::move( fnRead );
+            fnRead = nullptr;
+            readEc = readError;
+            nReadDone = nRead;
+        }
+        if( fnWrite && ( nEvents & ( EPOLLOUT | EPOLLHUP | EPOLLERR ) ) && TryWrite() ) {
+            fnWriteDone = std::move( fnWrite );
+            fnWrite = nullptr;
+            writeEc = writeError;
+            nWriteDone = nWritten;
+        }
+    }
+
+    // Already on the reactor thread and outside of any initiating function - no need to post
+    if( fnReadDone ) {
+        fnReadDone( readEc, nReadDone );
+    }
+    if( fnWriteDone ) {
+        fnWriteDone( writeEc, nWriteDone );
+    }
+}
+
+bool CEpollSerialTransport::CChannel::TryRead()
+{
+    ssize_t nResult;
+    do {
+        nResult = ::read( fd, readBuffer.data(), readBuffer.size() );
+    } while( nResult < 0 && errno == EINTR );
+
+    if( nResult > 0 ) {
+        readError = {};
+        nRead = static_cast< size_t >( nResult );
+        bReadable = nRead == readBuffer.size();
+        return true;
+    }
+    if( nResult == 0 ) {
+        // Hang-up: the device is gone
+        readError = boost::asio::error::eof;
+        nRead = 0;
+        return true;
+    }
+    if( errno == EAGAIN ) {
+        bReadable = false;
+        return false;
+    }
+    readError = _errno_error();
+    nRead = 0;
+    return true;
+}
+
+bool CEpollSerialTransport::CChannel::TryWrite()
+{
+    while( !vWrite.empty() ) {
+        ssize_t nResult = _writev( fd, vWrite );
+        if( nResult < 0 ) {
+            if( errno == EAGAIN ) {
+                if( !bWatchingOutput ) {
+                    bWatchingOutput = true;
+                    CEpollReactor::Instance().WatchOutput( fd );
+                }
+                return false;
+            }
+            writeError = _errno_error();
+            vWrite.clear();
+            return true;
+        }
+        nWritten += static_cast< size_t >( nResult );
+        _consume( vWrite, static_cast< size_t >( nResult ) );
+    }
+    writeError = {};
+    return true;
+}
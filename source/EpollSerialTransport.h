@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include "Transport.h"
+#include "EpollReactor.h"
+
+// A serial device node served without boost::asio: raw open()/termios, a non-blocking descriptor
+// in the shared CEpollReactor and read()/writev() straight into the caller's buffers.
+// The handlers are called from the reactor thread, never from the initiating function.
+// One read and one write may be pending at a time
+class CEpollSerialTransport : public CTransport {
+public:
+    explicit CEpollSerialTransport( std::string strName );
+    ~CEpollSerialTransport() override;
+
+    std::string GetName() const override { return m_strName; }
+
+    void Open( const std::string& strDevicePath, boost::system::error_code& ec ) override;
+    bool IsOpen() const override;
+    void Close() override;
+    void Cancel() override;
+
+    void SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec ) override;
+
+    void AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler ) override;
+    void AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler ) override;
+    size_t Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec ) override;
+
+    int GetTtyHandle() override;
+    bool HasOwnReactor() const override { return true; }
+
+private:
+    // The descriptor and its pending operations. Shared with the reactor, which may still be
+    // delivering an event while the transport closes
+    class CChannel : public CEpollReactor::IHandler {
+    public:
+        void OnEvents( uint32_t nEvents ) override;
+
+        // Both called under mtx. Return true once the pending operation is complete
+        bool TryRead();
+        bool TryWrite();
+
+        std::mutex mtx;
+        // Changed under mtx. Read without it by the blocking Write() and the tty tuning
+        std::atomic< int > fd{ -1 };
+        // Blocking Write() calls using the descriptor, guarded by mtx. Close() waits for them on cvWriters
+        // before it closes the descriptor, so they never write to a reused number
+        size_t nWriters{ 0 };
+        std::condition_variable cvWriters;
+        // An input edge came while no read was pending. Otherwise the last read drained the kernel
+        // buffer and the next edge will tell about new data - no speculative read() needed
+        bool bReadable{ true };
+        bool bWatchingOutput{ false };
+
+        boost::asio::mutable_buffer readBuffer;
+        io_handler_t fnRead;
+        boost::system::error_code readError;
+        size_t nRead{ 0 };
+
+        std::vector< boost::asio::const_buffer > vWrite;    // what is left to write
+        io_handler_t fnWrite;
+        boost::system::error_code writeError;
+        size_t nWritten{ 0 };
+    };
+
+    static void _post( io_handler_t fnHandler, const boost::system::error_code& ec, size_t nBytes );
+    // The blocking write loop of Write(), fd is kept open by the caller
+    size_t _write_all( int fd, const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec );
+
+private:
+    std::string m_strName;
+    std::shared_ptr< CChannel > m_channel;
+};
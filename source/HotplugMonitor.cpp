@@ -0,0 +1,142 @@
+#include "HotplugMonitor.h"
+#include "SerialPortManager.h"
+#include "ThreadedSerialPort.h"
+#include <cstring>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <boost/bind.hpp>
+
+namespace {
+    const char* const DEV_DIR = "/dev";
+    const char* const SERIAL_DIR = "/dev/serial";
+    const char* const BY_ID_DIR = "/dev/serial/by-id";
+
+    // A device node appears (IN_CREATE), gets its permissions from udev (IN_ATTRIB) or a symlink is renamed in place
+    const uint32_t WATCH_MASK = IN_CREATE | IN_ATTRIB | IN_MOVED_TO;
+}
+
+CHotplugMonitor& CHotplugMonitor::Instance()
+{
+    static CHotplugMonitor monitor;
+    return monitor;
+}
+
+CHotplugMonitor::~CHotplugMonitor()
+{
+    std::lock_guard< std::mutex > _{ m_mtx };
+    _stop();
+}
+
+bool CHotplugMonitor::Subscribe( CThreadedSerialPort* pPort )
+{
+    std::lock_guard< std::mutex > _{ m_mtx };
+
+    if( !m_descriptor && !_start() ) {
+        return false;
+    }
+    m_ports.insert( pPort );
+    return true;
+}
+
+void CHotplugMonitor::Unsubscribe( CThreadedSerialPort* pPort )
+{
+    std::lock_guard< std::mutex > _{ m_mtx };
+
+    if( 0 == m_ports.erase( pPort ) ) {
+        return;
+    }
+    if( m_ports.empty() ) {
+        _stop();
+    }
+}
+
+bool CHotplugMonitor::_start()
+{
+    int fd = ::inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+    if( fd < 0 ) {
+        return false;
+    }
+
+    m_nDevWatch = ::inotify_add_watch( fd, DEV_DIR, WATCH_MASK );
+    if( m_nDevWatch < 0 ) {
+        ::close( fd );
+        return false;
+    }
+
+    m_descriptor.reset( new boost::asio::posix::stream_descriptor( CSerialPortManager::Instance().GetIoService(), fd ) );
+    _add_missing_watches();
+    _async_read();
+    return true;
+}
+
+void CHotplugMonitor::_stop()
+{
+    if( m_descriptor ) {
+        // The pending read completes with operation_aborted and is not re-armed
+        boost::system::error_code ec;
+        m_descriptor->close( ec );
+        m_descriptor.reset();
+    }
+    m_nDevWatch = m_nSerialWatch = m_nByIdWatch = -1;
+}
+
+void CHotplugMonitor::_add_missing_watches()
+{
+    // udev creates /dev/serial/by-id with the first usb-serial device and may remove it with the last one
+    const int fd = m_descriptor->native_handle();
+    if( m_nSerialWatch < 0 ) {
+        m_nSerialWatch = ::inotify_add_watch( fd, SERIAL_DIR, WATCH_MASK );
+    }
+    if( m_nByIdWatch < 0 ) {
+        m_nByIdWatch = ::inotify_add_watch( fd, BY_ID_DIR, WATCH_MASK );
+    }
+}
+
+void CHotplugMonitor::_async_read()
+{
+    m_descriptor->async_read_some( boost::asio::buffer( m_buffer ),
+                                   boost::bind( &CHotplugMonitor::handle_read, this,
+                                                boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred ) );
+}
+
+void CHotplugMonitor::handle_read( const boost::system::error_code& error, size_t bytes_transferred )
+{
+    std::lock_guard< std::mutex > _{ m_mtx };
+
+    if( error || !m_descriptor ) {
+        return;
+    }
+
+    bool bRelevant{ false };
+    for( size_t nOffset = 0; nOffset + sizeof( inotify_event ) <= bytes_transferred; ) {
+        inotify_event event;
+        std::memcpy( &event, m_buffer.data() + nOffset, sizeof( event ) );
+        const char* szName = reinterpret_cast< const char* >( m_buffer.data() + nOffset + sizeof( event ) );
+
+        if( event.mask & IN_IGNORED ) {
+            // The watched directory is gone
+            if( event.wd == m_nSerialWatch ) {
+                m_nSerialWatch = -1;
+            } else if( event.wd == m_nByIdWatch ) {
+                m_nByIdWatch = -1;
+            }
+        } else if( event.wd == m_nDevWatch ) {
+            // Only tty nodes are interesting in /dev
+            bRelevant = bRelevant || ( event.len > 0 && 0 == std::strncmp( szName, "tty", 3 ) );
+        } else {
+            bRelevant = true;
+        }
+
+        nOffset += sizeof( inotify_event ) + event.len;
+    }
+
+    _add_missing_watches();
+
+    if( bRelevant ) {
+        for( auto pPort : m_ports ) {
+            pPort->_on_hotplug();
+        }
+    }
+
+    _async_read();
+}
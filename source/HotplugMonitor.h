@@ -0,0 +1,46 @@
+#pragma once
+
+#include <set>
+#include <mutex>
+#include <array>
+#include <boost/asio.hpp>
+
+class CThreadedSerialPort;
+
+// Watches /dev and /dev/serial/by-id with inotify on the shared reactor (see CSerialPortManager)
+// and wakes the ports waiting for their device to come back.
+// The watch is active only while there is at least one subscriber
+class CHotplugMonitor {
+public:
+    static CHotplugMonitor& Instance();
+
+    CHotplugMonitor( const CHotplugMonitor& ) = delete;
+    CHotplugMonitor& operator=( const CHotplugMonitor& ) = delete;
+
+    // Returns false if inotify is not available, the port has to rely on its retry timer then.
+    // No notifications are delivered to the port once Unsubscribe() has returned
+    bool Subscribe( CThreadedSerialPort* pPort );
+    void Unsubscribe( CThreadedSerialPort* pPort );
+
+private:
+    CHotplugMonitor() = default;
+    ~CHotplugMonitor();
+
+    bool _start();
+    void _stop();
+    void _add_missing_watches();
+    void _async_read();
+    void handle_read( const boost::system::error_code& error, size_t bytes_transferred );
+
+private:
+    std::mutex m_mtx;
+
+    std::set< CThreadedSerialPort* > m_ports;
+
+    std::unique_ptr< boost::asio::posix::stream_descriptor > m_descriptor;
+    int m_nDevWatch{ -1 };
+    int m_nSerialWatch{ -1 };
+    int m_nByIdWatch{ -1 };
+
+    std::array< uint8_t, 4096 > m_buffer;
+};
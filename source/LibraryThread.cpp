@@ -0,0 +1,284 @@
+#include "LibraryThread.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <system_error>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    // Linux thread names are limited to 15 characters
+    const size_t THREAD_NAME_MAX = 15;
+
+    std::mutex g_threads_mtx;
+    SThreadAttributes g_attributes[ 3 ];
+    bool g_bConfigured[ 3 ] = { false, false, false };
+    // The running threads by TID
+    struct SRunning {
+        pthread_t thread;
+        std::string strSuffix;
+        SThreadState state;
+    };
+    std::map< pid_t, SRunning > g_threads;
+    // Role of the calling thread, -1 outside the library threads
+    thread_local int g_nCurrentRole{ -1 };
+
+    size_t _index( EThreadRole eRole )
+    {
+        return static_cast< size_t >( eRole );
+    }
+
+    const char* _default_name( EThreadRole eRole )
+    {
+        switch( eRole ) {
+            case EThreadRole::Reactor: return "ssp-io";
+            case EThreadRole::Download: return "ssp-download";
+            case EThreadRole::Discovery: return "ssp-probe";
+        }
+        return "ssp";
+    }
+
+    pid_t _gettid()
+    {
+        return static_cast< pid_t >( ::syscall( SYS_gettid ) );
+    }
+
+    void _add_error( SThreadState& state, const char* szWhat, int nError )
+    {
+        if( !state.strError.empty() ) {
+            state.strError += "; ";
+        }
+        state.strError += std::string( szWhat ) + ": " + std::strerror( nError );
+    }
+
+    std::string _thread_name( EThreadRole eRole, const SThreadAttributes& attributes, const std::string& strSuffix )
+    {
+        std::string strName = ( attributes.strName.empty() ? std::string( _default_name( eRole ) ) : attributes.strName ) + strSuffix;
+        strName.resize( std::min( strName.size(), THREAD_NAME_MAX ) );
+        return strName;
+    }
+
+    // Applies what the role requests to the thread (the calling one or any other running library thread),
+    // then reads back what it effectively got. bReapply: the thread is running and may still have previous settings
+    SThreadState _apply( pthread_t self, pid_t nTid, EThreadRole eRole, const SThreadAttributes& attributes, bool bConfigured,
+                         const std::string& strName, bool bReapply )
+    {
+        SThreadState state;
+        state.eRole = eRole;
+        state.strName = strName;
+        state.nTid = nTid;
+
+        ::pthread_setname_np( self, strName.c_str() );
+
+        if( bConfigured ) {
+            if( !attributes.vCpus.empty() || bReapply ) {
+                cpu_set_t cpus;
+                CPU_ZERO( &cpus );
+                if( attributes.vCpus.empty() ) {
+                    // Back to any CPU of the process
+                    ::sched_getaffinity( ::getpid(), sizeof( cpus ), &cpus );
+                }
+                for( auto nCpu : attributes.vCpus ) {
+                    if( nCpu >= 0 && nCpu < CPU_SETSIZE ) {
+                        CPU_SET( nCpu, &cpus );
+                    }
+                }
+                if( int nError = ::pthread_setaffinity_np( self, sizeof( cpus ), &cpus ) ) {
+                    _add_error( state, "affinity", nError );
+                }
+            }
+
+            if( attributes.nPolicy == SCHED_FIFO ) {
+                sched_param param{};
+                param.sched_priority = attributes.nPriority;
+                if( int nError = ::pthread_setschedparam( self, SCHED_FIFO, &param ) ) {
+                    _add_error( state, "SCHED_FIFO", nError );
+                }
+            } else {
+                int nPolicy{ SCHED_OTHER };
+                sched_param param{};
+                if( bReapply && 0 == ::pthread_getschedparam( self, &nPolicy, &param ) && nPolicy != SCHED_OTHER ) {
+                    param.sched_priority = 0;
+                    if( int nError = ::pthread_setschedparam( self, SCHED_OTHER, &param ) ) {
+                        _add_error( state, "SCHED_OTHER", nError );
+                    }
+                }
+                // Linux keeps the nice value per thread
+                if( ( attributes.nNice != 0 || bReapply )
+                    && ::setpriority( PRIO_PROCESS, static_cast< id_t >( state.nTid ), attributes.nNice ) != 0 ) {
+                    _add_error( state, "nice", errno );
+                }
+            }
+        }
+
+        sched_param param{};
+        if( 0 == ::pthread_getschedparam( self, &state.nPolicy, &param ) ) {
+            state.nPriority = param.sched_priority;
+        }
+        errno = 0;
+        state.nNice = ::getpriority( PRIO_PROCESS, static_cast< id_t >( state.nTid ) );
+
+        cpu_set_t cpus;
+        CPU_ZERO( &cpus );
+        if( 0 == ::pthread_getaffinity_np( self, sizeof( cpus ), &cpus ) ) {
+            for( int nCpu = 0; nCpu < CPU_SETSIZE; ++nCpu ) {
+                if( CPU_ISSET( nCpu, &cpus ) ) {
+                    state.vCpus.push_back( nCpu );
+                }
+            }
+        }
+
+        pthread_attr_t attr;
+        if( 0 == ::pthread_getattr_np( self, &attr ) ) {
+            ::pthread_attr_getstacksize( &attr, &state.nStackSize );
+            ::pthread_attr_destroy( &attr );
+        }
+
+        return state;
+    }
+}
+
+struct CLibraryThread::SStart {
+    EThreadRole eRole;
+    SThreadAttributes attributes;
+    bool bConfigured;
+    std::string strSuffix;
+    std::unique_ptr< IRunnable > pRunnable;
+};
+
+void CLibraryThread::SetAttributes( EThreadRole eRole, const SThreadAttributes& attributes )
+{
+    std::lock_guard< std::mutex > _lck( g_threads_mtx );
+    g_attributes[ _index( eRole ) ] = attributes;
+    g_bConfigured[ _index( eRole ) ] = true;
+
+    // A thread stays in the registry until it is about to exit, so its handle is valid here
+    for( auto& item : g_threads ) {
+        SRunning& running = item.second;
+        if( running.state.eRole == eRole ) {
+            running.state = _apply( running.thread, item.first, eRole, attributes, true, _thread_name( eRole, attributes, running.strSuffix ), true );
+        }
+    }
+}
+
+SThreadAttributes CLibraryThread::GetAttributes( EThreadRole eRole )
+{
+    std::lock_guard< std::mutex > _lck( g_threads_mtx );
+    return g_attributes[ _index( eRole ) ];
+}
+
+std::vector< SThreadState > CLibraryThread::GetThreadStates()
+{
+    std::lock_guard< std::mutex > _lck( g_threads_mtx );
+    std::vector< SThreadState > vStates;
+    for( const auto& item : g_threads ) {
+        vStates.push_back( item.second.state );
+    }
+    return vStates;
+}
+
+CLibraryThread::CLibraryThread( CLibraryThread&& other ) noexcept
+    : m_thread( other.m_thread )
+    , m_bJoinable( other.m_bJoinable )
+{
+    other.m_bJoinable = false;
+}
+
+CLibraryThread& CLibraryThread::operator=( CLibraryThread&& other ) noexcept
+{
+    if( this != &other ) {
+        if( m_bJoinable ) {
+            Join();
+        }
+        m_thread = other.m_thread;
+        m_bJoinable = other.m_bJoinable;
+        other.m_bJoinable = false;
+    }
+    return *this;
+}
+
+CLibraryThread::~CLibraryThread()
+{
+    if( m_bJoinable ) {
+        Join();
+    }
+}
+
+void CLibraryThread::Join()
+{
+    if( m_bJoinable ) {
+        ::pthread_join( m_thread, nullptr );
+        m_bJoinable = false;
+    }
+}
+
+void CLibraryThread::Detach()
+{
+    if( m_bJoinable ) {
+        ::pthread_detach( m_thread );
+        m_bJoinable = false;
+    }
+}
+
+bool CLibraryThread::IsCurrent() const
+{
+    return m_bJoinable && ::pthread_equal( m_thread, ::pthread_self() );
+}
+
+bool CLibraryThread::IsCurrentRole( EThreadRole eRole )
+{
+    return g_nCurrentRole == static_cast< int >( _index( eRole ) );
+}
+
+void CLibraryThread::_start( EThreadRole eRole, std::unique_ptr< IRunnable > pRunnable, const std::string& strSuffix )
+{
+    std::unique_ptr< SStart > pStart( new SStart{ eRole, {}, false, strSuffix, std::move( pRunnable ) } );
+    {
+        std::lock_guard< std::mutex > _lck( g_threads_mtx );
+        pStart->attributes = g_attributes[ _index( eRole ) ];
+        pStart->bConfigured = g_bConfigured[ _index( eRole ) ];
+    }
+
+    pthread_attr_t attr;
+    ::pthread_attr_init( &attr );
+    if( pStart->bConfigured && pStart->attributes.nStackSize > 0 ) {
+        ::pthread_attr_setstacksize( &attr, std::max< size_t >( pStart->attributes.nStackSize, PTHREAD_STACK_MIN ) );
+    }
+
+    int nError = ::pthread_create( &m_thread, &attr, &CLibraryThread::_fnEntry, pStart.get() );
+    ::pthread_attr_destroy( &attr );
+    if( nError ) {
+        throw std::system_error( nError, std::generic_category(), "pthread_create" );
+    }
+
+    // The thread owns the start block now
+    pStart.release();
+    m_bJoinable = true;
+}
+
+void* CLibraryThread::_fnEntry( void* pArg )
+{
+    std::unique_ptr< SStart > pStart( static_cast< SStart* >( pArg ) );
+    g_nCurrentRole = static_cast< int >( _index( pStart->eRole ) );
+
+    const pid_t nTid = _gettid();
+    {
+        // Registered under the same lock as SetAttributes() so no change of the attributes is missed
+        std::lock_guard< std::mutex > _lck( g_threads_mtx );
+        const SThreadAttributes& attributes = g_attributes[ _index( pStart->eRole ) ];
+        const bool bConfigured = g_bConfigured[ _index( pStart->eRole ) ];
+        g_threads[ nTid ] = SRunning{ ::pthread_self(), pStart->strSuffix,
+                                      _apply( ::pthread_self(), nTid, pStart->eRole, attributes, bConfigured,
+                                              _thread_name( pStart->eRole, attributes, pStart->strSuffix ), false ) };
+    }
+
+    pStart->pRunnable->Run();
+
+    std::lock_guard< std::mutex > _lck( g_threads_mtx );
+    g_threads.erase( nTid );
+    return nullptr;
+}
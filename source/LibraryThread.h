@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include <type_traits>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/types.h>
+
+// Kinds of the threads the library creates
+enum class EThreadRole {
+    Reactor,        // CSerialPortManager pool: all the port I/O
+    Download,       // firmware download started by DownloadFileToTarget()
+    Discovery       // one per port probed by DiscoverSSPDevices() or opened by OpenSSPPorts()
+};
+
+// Requested scheduling of a thread role. Applied by every thread of the role as it starts
+// and to the threads of the role already running when the attributes change
+struct SThreadAttributes {
+    std::vector< int > vCpus;           // affinity, empty - any CPU
+    int nPolicy{ SCHED_OTHER };         // SCHED_OTHER or SCHED_FIFO
+    int nPriority{ 0 };                 // SCHED_FIFO priority 1..99
+    int nNice{ 0 };                     // SCHED_OTHER nice value -20..19
+    size_t nStackSize{ 0 };             // bytes, 0 - the system default
+    std::string strName;                // up to 15 characters, empty - "ssp-io", "ssp-download", "ssp-probe"
+};
+
+// What a running library thread effectively got. The settings the system refused
+// (e.g. SCHED_FIFO without CAP_SYS_NICE) keep their defaults and are named in strError
+struct SThreadState {
+    EThreadRole eRole{ EThreadRole::Reactor };
+    std::string strName;
+    pid_t nTid{ 0 };
+    int nPolicy{ SCHED_OTHER };
+    int nPriority{ 0 };
+    int nNice{ 0 };
+    std::vector< int > vCpus;
+    size_t nStackSize{ 0 };
+    std::string strError;
+};
+
+// std::thread alike for the threads of the library, started with the attributes configured
+// for its role. Unlike std::thread the destructor joins a joinable thread
+class CLibraryThread {
+public:
+    // Applied at once to the running threads of the role, except the stack size which affects the threads
+    // started afterwards only. The roles never configured run with the process defaults
+    static void SetAttributes( EThreadRole eRole, const SThreadAttributes& attributes );
+    static SThreadAttributes GetAttributes( EThreadRole eRole );
+
+    // All the library threads running now
+    static std::vector< SThreadState > GetThreadStates();
+
+    CLibraryThread() = default;
+
+    // Throws std::system_error if the thread cannot be started. strSuffix is appended to the name
+    template< typename F >
+    CLibraryThread( EThreadRole eRole, F&& fn, const std::string& strSuffix = {} )
+    {
+        _start( eRole, std::unique_ptr< IRunnable >( new CRunnable< typename std::decay< F >::type >( std::forward< F >( fn ) ) ), strSuffix );
+    }
+
+    CLibraryThread( CLibraryThread&& other ) noexcept;
+    CLibraryThread& operator=( CLibraryThread&& other ) noexcept;
+    CLibraryThread( const CLibraryThread& ) = delete;
+    CLibraryThread& operator=( const CLibraryThread& ) = delete;
+    ~CLibraryThread();
+
+    bool Joinable() const { return m_bJoinable; }
+    void Join();
+    void Detach();
+
+    // True if called from this thread
+    bool IsCurrent() const;
+
+    // True if called from any library thread of the role
+    static bool IsCurrentRole( EThreadRole eRole );
+
+private:
+    struct IRunnable {
+        virtual ~IRunnable() = default;
+        virtual void Run() = 0;
+    };
+
+    // Move-only callables are fine, unlike std::function
+    template< typename F >
+    struct CRunnable : IRunnable {
+        explicit CRunnable( F&& fn ) : m_fn( std::move( fn ) ) {}
+        explicit CRunnable( const F& fn ) : m_fn( fn ) {}
+        void Run() override { m_fn(); }
+        F m_fn;
+    };
+
+    struct SStart;
+
+    void _start( EThreadRole eRole, std::unique_ptr< IRunnable > pRunnable, const std::string& strSuffix );
+    static void* _fnEntry( void* pArg );
+
+private:
+    pthread_t m_thread{};
+    bool m_bJoinable{ false };
+};
@@ -0,0 +1,139 @@
+#include "MemoryTransport.h"
+#include <algorithm>
+
+std::pair< std::unique_ptr< CMemoryTransport >, std::unique_ptr< CMemoryTransport > >
+CMemoryTransport::CreatePair( boost::asio::io_service& io_service, const std::string& strName )
+{
+    auto pPipe = std::make_shared< SPipe >();
+    return { std::unique_ptr< CMemoryTransport >( new CMemoryTransport( io_service, pPipe, 0, strName ) ),
+             std::unique_ptr< CMemoryTransport >( new CMemoryTransport( io_service, pPipe, 1, strName ) ) };
+}
+
+CMemoryTransport::CMemoryTransport( boost::asio::io_service& io_service, std::shared_ptr< SPipe > pPipe, size_t nSide, std::string strName )
+    : m_io_service( io_service )
+    , m_pPipe{ std::move( pPipe ) }
+    , m_nSide{ nSide }
+    , m_strName{ std::move( strName ) }
+{
+}
+
+CMemoryTransport::~CMemoryTransport()
+{
+    Close();
+    std::lock_guard< std::mutex > _lck( m_pPipe->mtx );
+    m_pPipe->bAlive[ m_nSide ] = false;
+}
+
+void CMemoryTransport::Open( const std::string& /* strDevicePath */, boost::system::error_code& ec )
+{
+    std::lock_guard< std::mutex > _lck( m_pPipe->mtx );
+    if( !m_pPipe->bAlive[ 1 - m_nSide ] ) {
+        ec = boost::asio::error::connection_refused;
+        return;
+    }
+    ec.clear();
+    m_pPipe->bOpen[ m_nSide ] = true;
+    m_pPipe->data[ m_nSide ].clear();
+}
+
+bool CMemoryTransport::IsOpen() const
+{
+    std::lock_guard< std::mutex > _lck( m_pPipe->mtx );
+    return m_pPipe->bOpen[ m_nSide ];
+}
+
+void CMemoryTransport::Close()
+{
+    std::lock_guard< std::mutex > _lck( m_pPipe->mtx );
+    if( !m_pPipe->bOpen[ m_nSide ] ) {
+        return;
+    }
+    m_pPipe->bOpen[ m_nSide ] = false;
+    _complete_read( m_nSide, boost::asio::error::operation_aborted );
+    _complete_read( 1 - m_nSide, boost::asio::error::eof );
+}
+
+void CMemoryTransport::Cancel()
+{
+    std::lock_guard< std::mutex > _lck( m_pPipe->mtx );
+    _complete_read( m_nSide, boost::asio::error::operation_aborted );
+}
+
+void CMemoryTransport::SetLineSettings( const SLineSettings& /* settings */, boost::system::error_code& ec )
+{
+    ec.clear();
+}
+
+void CMemoryTransport::AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler )
+{
+    std::lock_guard< std::mutex > _lck( m_pPipe->mtx );
+
+    m_pPipe->readBuffer[ m_nSide ] = buffer;
+    m_pPipe->fnReadHandler[ m_nSide ] = std::move( fnHandler );
+
+    if( !m_pPipe->bOpen[ m_nSide ] ) {
+        _complete_read( m_nSide, boost::asio::error::bad_descriptor );
+    } else if( !m_pPipe->data[ m_nSide ].empty() ) {
+        _complete_read( m_nSide, {} );
+    }
+    // Otherwise wait for the data. The peer may be not opened yet
+}
+
+void CMemoryTransport::AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler )
+{
+    // The pipe never blocks: the data is taken at once
+    boost::system::error_code ec;
+    size_t nBytes = Write( pBuffers, nBuffers, ec );
+    m_io_service.post( [ fnHandler, ec, nBytes ] { fnHandler( ec, nBytes ); } );
+}
+
+size_t CMemoryTransport::Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec )
+{
+    std::lock_guard< std::mutex > _lck( m_pPipe->mtx );
+
+    const size_t nPeer = 1 - m_nSide;
+    if( !m_pPipe->bOpen[ m_nSide ] ) {
+        ec = boost::asio::error::bad_descriptor;
+        return 0;
+    }
+    if( !m_pPipe->bOpen[ nPeer ] ) {
+        ec = boost::asio::error::broken_pipe;
+        return 0;
+    }
+
+    ec.clear();
+    size_t nTotal{ 0 };
+    auto& data = m_pPipe->data[ nPeer ];
+    for( size_t i = 0; i < nBuffers; ++i ) {
+        const auto* p = static_cast< const uint8_t* >( pBuffers[ i ].data() );
+        data.insert( data.end(), p, p + pBuffers[ i ].size() );
+        nTotal += pBuffers[ i ].size();
+    }
+
+    _complete_read( nPeer, {} );
+    return nTotal;
+}
+
+void CMemoryTransport::_complete_read( size_t nSide, const boost::system::error_code& error )
+{
+    if( !m_pPipe->fnReadHandler[ nSide ] ) {
+        return;
+    }
+
+    size_t nBytes{ 0 };
+    if( !error ) {
+        auto& data = m_pPipe->data[ nSide ];
+        auto buffer = m_pPipe->readBuffer[ nSide ];
+        nBytes = std::min( data.size(), buffer.size() );
+        if( 0 == nBytes ) {
+            return;
+        }
+        std::copy( data.begin(), data.begin() + nBytes, static_cast< uint8_t* >( buffer.data() ) );
+        data.erase( data.begin(), data.begin() + nBytes );
+    }
+
+    // Never call the handler in place: the caller holds the pipe mutex
+    io_handler_t fnHandler = std::move( m_pPipe->fnReadHandler[ nSide ] );
+    m_pPipe->fnReadHandler[ nSide ] = nullptr;
+    m_io_service.post( [ fnHandler, error, nBytes ] { fnHandler( error, nBytes ); } );
+}
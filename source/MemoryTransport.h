@@ -0,0 +1,55 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <utility>
+#include "Transport.h"
+
+// One end of an in-process byte pipe. Whatever is written to one end is read from the other one.
+// Lets the whole stack run against an in-process emulator (e.g. another CThreadedSerialPort on the peer end)
+// with no kernel and no UART in the way
+class CMemoryTransport : public CTransport {
+    struct SPipe;
+public:
+    static std::pair< std::unique_ptr< CMemoryTransport >, std::unique_ptr< CMemoryTransport > >
+    CreatePair( boost::asio::io_service& io_service, const std::string& strName = "mem://" );
+
+    std::string GetName() const override { return m_strName; }
+
+    // Reopening is allowed while the peer end exists
+    void Open( const std::string& strDevicePath, boost::system::error_code& ec ) override;
+    bool IsOpen() const override;
+    // The peer's pending read completes with eof, its writes fail with broken_pipe until this end is reopened
+    void Close() override;
+    void Cancel() override;
+
+    void SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec ) override;
+
+    void AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler ) override;
+    void AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler ) override;
+    size_t Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec ) override;
+
+    ~CMemoryTransport() override;
+
+private:
+    CMemoryTransport( boost::asio::io_service& io_service, std::shared_ptr< SPipe > pPipe, size_t nSide, std::string strName );
+
+    // Completes the pending read of nSide if there is something to complete it with. Called under the pipe mutex
+    void _complete_read( size_t nSide, const boost::system::error_code& error );
+
+private:
+    // Two directions, m_data[ n ] is read by side n
+    struct SPipe {
+        std::mutex mtx;
+        std::deque< uint8_t > data[ 2 ];
+        bool bOpen[ 2 ]{ false, false };
+        bool bAlive[ 2 ]{ true, true };
+        boost::asio::mutable_buffer readBuffer[ 2 ];
+        io_handler_t fnReadHandler[ 2 ];
+    };
+
+    boost::asio::io_service& m_io_service;
+    std::shared_ptr< SPipe > m_pPipe;
+    const size_t m_nSide;
+    const std::string m_strName;
+};
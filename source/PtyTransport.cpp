@@ -0,0 +1,79 @@
+#include "PtyTransport.h"
+#include <cstdlib>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+CPtyTransport::CPtyTransport( boost::asio::io_service& io_service )
+    : m_master{ io_service }
+{
+}
+
+void CPtyTransport::Open( const std::string& /* strDevicePath */, boost::system::error_code& ec )
+{
+    ec.clear();
+
+    int fd = ::posix_openpt( O_RDWR | O_NOCTTY | O_CLOEXEC );
+    if( fd < 0 || ::grantpt( fd ) != 0 || ::unlockpt( fd ) != 0 ) {
+        ec.assign( errno, boost::system::system_category() );
+        if( fd >= 0 ) {
+            ::close( fd );
+        }
+        return;
+    }
+
+    // No echo, no line discipline: the bytes pass as they are
+    struct termios tio{};
+    if( ::tcgetattr( fd, &tio ) == 0 ) {
+        ::cfmakeraw( &tio );
+        ::tcsetattr( fd, TCSANOW, &tio );
+    }
+
+    char szSlaveName[ 64 ];
+    if( ::ptsname_r( fd, szSlaveName, sizeof( szSlaveName ) ) != 0 ) {
+        ec.assign( errno, boost::system::system_category() );
+        ::close( fd );
+        return;
+    }
+
+    m_master.assign( fd, ec );
+    if( ec ) {
+        ::close( fd );
+        return;
+    }
+    m_strSlaveName = szSlaveName;
+}
+
+void CPtyTransport::Close()
+{
+    boost::system::error_code ec;
+    m_master.close( ec );
+    m_strSlaveName.clear();
+}
+
+void CPtyTransport::Cancel()
+{
+    boost::system::error_code ec;
+    m_master.cancel( ec );
+}
+
+void CPtyTransport::SetLineSettings( const SLineSettings& /* settings */, boost::system::error_code& ec )
+{
+    // The line belongs to the slave side
+    ec.clear();
+}
+
+void CPtyTransport::AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler )
+{
+    m_master.async_read_some( buffer, std::move( fnHandler ) );
+}
+
+void CPtyTransport::AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler )
+{
+    boost::asio::async_write( m_master, CConstBufferList{ pBuffers, nBuffers }, std::move( fnHandler ) );
+}
+
+size_t CPtyTransport::Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec )
+{
+    return boost::asio::write( m_master, CConstBufferList{ pBuffers, nBuffers }, ec );
+}
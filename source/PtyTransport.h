@@ -0,0 +1,30 @@
+#pragma once
+
+#include "Transport.h"
+
+// The master side of a new pseudo-terminal. A device emulator (or socat) attaches to GetSlaveName().
+// Every Open() creates a new pseudo-terminal
+class CPtyTransport : public CTransport {
+public:
+    explicit CPtyTransport( boost::asio::io_service& io_service );
+
+    std::string GetName() const override { return "pty://"; }
+
+    // E.g. "/dev/pts/3", empty while closed
+    std::string GetSlaveName() const { return m_strSlaveName; }
+
+    void Open( const std::string& strDevicePath, boost::system::error_code& ec ) override;
+    bool IsOpen() const override { return m_master.is_open(); }
+    void Close() override;
+    void Cancel() override;
+
+    void SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec ) override;
+
+    void AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler ) override;
+    void AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler ) override;
+    size_t Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec ) override;
+
+private:
+    boost::asio::posix::stream_descriptor m_master;
+    std::string m_strSlaveName;
+};
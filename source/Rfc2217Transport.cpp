@@ -0,0 +1,322 @@
+#include "Rfc2217Transport.h"
+#include <algorithm>
+#include <memory>
+
+namespace {
+    // Telnet, RFC 854
+    const uint8_t IAC = 255;
+    const uint8_t DONT = 254;
+    const uint8_t DO = 253;
+    const uint8_t WONT = 252;
+    const uint8_t WILL = 251;
+    const uint8_t SB = 250;
+    const uint8_t SE = 240;
+
+    const uint8_t OPT_BINARY = 0;
+    const uint8_t OPT_SUPPRESS_GO_AHEAD = 3;
+    const uint8_t OPT_COM_PORT = 44;
+
+    // RFC 2217 client to server commands. The server answers with the command + 100
+    const uint8_t SET_BAUDRATE = 1;
+    const uint8_t SET_DATASIZE = 2;
+    const uint8_t SET_PARITY = 3;
+    const uint8_t SET_STOPSIZE = 4;
+    const uint8_t SET_CONTROL = 5;
+    const uint8_t SERVER_OFFSET = 100;
+}
+
+CRfc2217Transport::CRfc2217Transport( boost::asio::io_service& io_service, std::string strHost, std::string strPort )
+    : CTcpTransport( io_service, std::move( strHost ), std::move( strPort ) )
+{
+}
+
+void CRfc2217Transport::Open( const std::string& strDevicePath, boost::system::error_code& ec )
+{
+    CTcpTransport::Open( strDevicePath, ec );
+    if( ec ) {
+        return;
+    }
+
+    m_state = EParserState::Data;
+    m_vSubnegotiation.clear();
+    m_bComPortAccepted = false;
+    m_nServerBaud = 0;
+    {
+        std::lock_guard< std::mutex > _lck( m_replies_mtx );
+        m_vReplies.clear();
+    }
+
+    // Not waiting for the answers: they are handled by the reader as they come
+    const uint8_t negotiation[] = {
+        IAC, WILL, OPT_COM_PORT,
+        IAC, WILL, OPT_BINARY, IAC, DO, OPT_BINARY,
+        IAC, WILL, OPT_SUPPRESS_GO_AHEAD, IAC, DO, OPT_SUPPRESS_GO_AHEAD
+    };
+    std::lock_guard< std::mutex > _lck( m_write_mtx );
+    m_bAsyncWriteActive = false;
+    boost::asio::write( m_socket, boost::asio::buffer( negotiation ), ec );
+}
+
+void CRfc2217Transport::SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec )
+{
+    const uint8_t baud[] = {
+        static_cast< uint8_t >( settings.nBaud >> 24 ), static_cast< uint8_t >( settings.nBaud >> 16 ),
+        static_cast< uint8_t >( settings.nBaud >> 8 ), static_cast< uint8_t >( settings.nBaud )
+    };
+    _send_com_port_command( SET_BAUDRATE, baud, sizeof( baud ), ec );
+
+    const uint8_t nDataSize = static_cast< uint8_t >( settings.nCharacterSize );
+    if( !ec ) {
+        _send_com_port_command( SET_DATASIZE, &nDataSize, 1, ec );
+    }
+
+    uint8_t nParity{ 1 };
+    switch( settings.parity ) {
+        case boost::asio::serial_port_base::parity::odd: nParity = 2; break;
+        case boost::asio::serial_port_base::parity::even: nParity = 3; break;
+        default: break;
+    }
+    if( !ec ) {
+        _send_com_port_command( SET_PARITY, &nParity, 1, ec );
+    }
+
+    uint8_t nStopSize{ 1 };
+    switch( settings.stopBits ) {
+        case boost::asio::serial_port_base::stop_bits::two: nStopSize = 2; break;
+        case boost::asio::serial_port_base::stop_bits::onepointfive: nStopSize = 3; break;
+        default: break;
+    }
+    if( !ec ) {
+        _send_com_port_command( SET_STOPSIZE, &nStopSize, 1, ec );
+    }
+
+    uint8_t nControl{ 1 };
+    switch( settings.flowControl ) {
+        case boost::asio::serial_port_base::flow_control::software: nControl = 2; break;
+        case boost::asio::serial_port_base::flow_control::hardware: nControl = 3; break;
+        default: break;
+    }
+    if( !ec ) {
+        _send_com_port_command( SET_CONTROL, &nControl, 1, ec );
+    }
+}
+
+void CRfc2217Transport::AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler )
+{
+    boost::system::error_code ec;
+    _flush_replies( ec );
+
+    m_socket.async_read_some( buffer, [ this, buffer, fnHandler ]( const boost::system::error_code& error, size_t bytes_transferred ) {
+        if( error ) {
+            fnHandler( error, bytes_transferred );
+            return;
+        }
+        fnHandler( error, _filter( static_cast< uint8_t* >( buffer.data() ), bytes_transferred ) );
+    } );
+}
+
+void CRfc2217Transport::AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler )
+{
+    auto pEscaped = std::make_shared< std::vector< uint8_t > >( _escape( pBuffers, nBuffers ) );
+
+    std::lock_guard< std::mutex > _lck( m_write_mtx );
+    boost::system::error_code ec;
+    _flush_replies_locked( ec );
+    m_bAsyncWriteActive = true;
+
+    // The answers queued meanwhile are sent once the data is out. The caller expects its own byte count
+    const size_t nSize = boost::asio::buffer_size( CConstBufferList{ pBuffers, nBuffers } );
+    auto fnCompletion = [ this, pEscaped, nSize, fnHandler ]( const boost::system::error_code& error, size_t ) {
+        {
+            std::lock_guard< std::mutex > _lck( m_write_mtx );
+            m_bAsyncWriteActive = false;
+            if( !error ) {
+                boost::system::error_code ec;
+                _flush_replies_locked( ec );
+            }
+        }
+        m_write_cv.notify_all();
+        fnHandler( error, error ? 0 : nSize );
+    };
+    if( pEscaped->empty() ) {
+        boost::asio::async_write( m_socket, CConstBufferList{ pBuffers, nBuffers }, std::move( fnCompletion ) );
+    } else {
+        boost::asio::async_write( m_socket, boost::asio::buffer( *pEscaped ), std::move( fnCompletion ) );
+    }
+}
+
+size_t CRfc2217Transport::Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec )
+{
+    std::vector< uint8_t > vEscaped = _escape( pBuffers, nBuffers );
+
+    std::unique_lock< std::mutex > _lck( m_write_mtx );
+    m_write_cv.wait( _lck, [ this ] { return !m_bAsyncWriteActive; } );
+    _flush_replies_locked( ec );
+    if( ec ) {
+        return 0;
+    }
+
+    if( vEscaped.empty() ) {
+        return CTcpTransport::Write( pBuffers, nBuffers, ec );
+    }
+
+    boost::asio::write( m_socket, boost::asio::buffer( vEscaped ), ec );
+    return ec ? 0 : boost::asio::buffer_size( CConstBufferList{ pBuffers, nBuffers } );
+}
+
+std::vector< uint8_t > CRfc2217Transport::_escape( const boost::asio::const_buffer* pBuffers, size_t nBuffers )
+{
+    std::vector< uint8_t > vEscaped;
+    bool bEscapeRequired{ false };
+    for( size_t i = 0; i < nBuffers && !bEscapeRequired; ++i ) {
+        const auto* p = static_cast< const uint8_t* >( pBuffers[ i ].data() );
+        bEscapeRequired = std::find( p, p + pBuffers[ i ].size(), IAC ) != p + pBuffers[ i ].size();
+    }
+    if( !bEscapeRequired ) {
+        return vEscaped;
+    }
+
+    for( size_t i = 0; i < nBuffers; ++i ) {
+        const auto* p = static_cast< const uint8_t* >( pBuffers[ i ].data() );
+        for( size_t j = 0; j < pBuffers[ i ].size(); ++j ) {
+            vEscaped.push_back( p[ j ] );
+            if( p[ j ] == IAC ) {
+                vEscaped.push_back( IAC );
+            }
+        }
+    }
+    return vEscaped;
+}
+
+size_t CRfc2217Transport::_filter( uint8_t* pData, size_t nSize )
+{
+    size_t nOut{ 0 };
+    for( size_t i = 0; i < nSize; ++i ) {
+        const uint8_t c = pData[ i ];
+        switch( m_state ) {
+            case EParserState::Data:
+                if( c == IAC ) {
+                    m_state = EParserState::Iac;
+                } else {
+                    pData[ nOut++ ] = c;
+                }
+                break;
+
+            case EParserState::Iac:
+                if( c == IAC ) {
+                    // Escaped 0xFF data byte
+                    pData[ nOut++ ] = c;
+                    m_state = EParserState::Data;
+                } else if( c == SB ) {
+                    m_vSubnegotiation.clear();
+                    m_state = EParserState::Sb;
+                } else if( c >= WILL && c <= DONT ) {
+                    m_nVerb = c;
+                    m_state = EParserState::Verb;
+                } else {
+                    // NOP, GA and the like
+                    m_state = EParserState::Data;
+                }
+                break;
+
+            case EParserState::Verb:
+                _on_command( m_nVerb, c );
+                m_state = EParserState::Data;
+                break;
+
+            case EParserState::Sb:
+                if( c == IAC ) {
+                    m_state = EParserState::SbIac;
+                } else if( m_vSubnegotiation.size() < 64 ) {
+                    m_vSubnegotiation.push_back( c );
+                }
+                break;
+
+            case EParserState::SbIac:
+                if( c == SE ) {
+                    _on_subnegotiation();
+                    m_state = EParserState::Data;
+                } else {
+                    if( m_vSubnegotiation.size() < 64 ) {
+                        m_vSubnegotiation.push_back( c );
+                    }
+                    m_state = EParserState::Sb;
+                }
+                break;
+        }
+    }
+    return nOut;
+}
+
+void CRfc2217Transport::_on_command( uint8_t nVerb, uint8_t nOption )
+{
+    const bool bSupported = nOption == OPT_COM_PORT || nOption == OPT_BINARY || nOption == OPT_SUPPRESS_GO_AHEAD;
+
+    if( nVerb == DO && nOption == OPT_COM_PORT ) {
+        m_bComPortAccepted = true;
+    }
+    if( nVerb == DONT && nOption == OPT_COM_PORT ) {
+        m_bComPortAccepted = false;
+    }
+
+    // Our options were offered on open, so DO / WILL of them are just the acknowledgements. Refuse the rest
+    uint8_t nAnswer{ 0 };
+    if( nVerb == DO && !bSupported ) {
+        nAnswer = WONT;
+    } else if( nVerb == WILL && !bSupported ) {
+        nAnswer = DONT;
+    }
+    if( nAnswer ) {
+        std::lock_guard< std::mutex > _lck( m_replies_mtx );
+        m_vReplies.insert( m_vReplies.end(), { IAC, nAnswer, nOption } );
+    }
+}
+
+void CRfc2217Transport::_on_subnegotiation()
+{
+    if( m_vSubnegotiation.size() == 6 && m_vSubnegotiation[ 0 ] == OPT_COM_PORT && m_vSubnegotiation[ 1 ] == SET_BAUDRATE + SERVER_OFFSET ) {
+        m_nServerBaud = ( static_cast< uint32_t >( m_vSubnegotiation[ 2 ] ) << 24 ) | ( static_cast< uint32_t >( m_vSubnegotiation[ 3 ] ) << 16 )
+                      | ( static_cast< uint32_t >( m_vSubnegotiation[ 4 ] ) << 8 ) | m_vSubnegotiation[ 5 ];
+    }
+}
+
+void CRfc2217Transport::_flush_replies( boost::system::error_code& ec )
+{
+    std::lock_guard< std::mutex > _lck( m_write_mtx );
+    _flush_replies_locked( ec );
+}
+
+void CRfc2217Transport::_flush_replies_locked( boost::system::error_code& ec )
+{
+    if( m_bAsyncWriteActive ) {
+        return;
+    }
+
+    std::vector< uint8_t > vReplies;
+    {
+        std::lock_guard< std::mutex > _lck( m_replies_mtx );
+        vReplies.swap( m_vReplies );
+    }
+    if( !vReplies.empty() ) {
+        boost::asio::write( m_socket, boost::asio::buffer( vReplies ), ec );
+    }
+}
+
+void CRfc2217Transport::_send_com_port_command( uint8_t nCommand, const uint8_t* pValue, size_t nSize, boost::system::error_code& ec )
+{
+    // IAC SB COM-PORT-OPTION <command> <value, IAC doubled> IAC SE. The values are up to 4 bytes
+    uint8_t command[ 4 + 2 * 4 + 2 ] = { IAC, SB, OPT_COM_PORT, nCommand };
+    size_t nLength{ 4 };
+    for( size_t i = 0; i < nSize && i < 4; ++i ) {
+        command[ nLength++ ] = pValue[ i ];
+        if( pValue[ i ] == IAC ) {
+            command[ nLength++ ] = IAC;
+        }
+    }
+    command[ nLength++ ] = IAC;
+    command[ nLength++ ] = SE;
+
+    std::unique_lock< std::mutex > _lck( m_write_mtx );
+    m_write_cv.wait( _lck, [ this ] { return !m_bAsyncWriteActive; } );
+    boost::asio::write( m_socket, boost::asio::buffer( command, nLength ), ec );
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+#include "TcpTransport.h"
+
+// Serial device server speaking Telnet with the RFC 2217 COM-PORT-OPTION ("rfc2217://host:port").
+// The line settings of CThreadedSerialPort are forwarded to the server, the data is IAC-escaped both ways
+class CRfc2217Transport : public CTcpTransport {
+public:
+    CRfc2217Transport( boost::asio::io_service& io_service, std::string strHost, std::string strPort );
+
+    std::string GetName() const override { return "rfc2217://" + m_strHost + ":" + m_strPort; }
+
+    void Open( const std::string& strDevicePath, boost::system::error_code& ec ) override;
+
+    void SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec ) override;
+
+    // Completes with the data bytes only. A read that got Telnet commands only completes with 0 bytes
+    void AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler ) override;
+    void AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler ) override;
+    size_t Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec ) override;
+
+    // True once the server agreed to COM-PORT-OPTION
+    bool IsComPortControlAccepted() const { return m_bComPortAccepted; }
+    // The baud rate the server reported back for the last SET-BAUDRATE, 0 if none yet
+    uint32_t GetServerBaud() const { return m_nServerBaud; }
+
+private:
+    // Strips the Telnet commands in place, returns the number of data bytes left
+    size_t _filter( uint8_t* pData, size_t nSize );
+    void _on_command( uint8_t nVerb, uint8_t nOption );
+    void _on_subnegotiation();
+    // Sends the negotiation answers queued by the reader unless a data write is in progress, which sends them on completion
+    void _flush_replies( boost::system::error_code& ec );
+    // Same with m_write_mtx held
+    void _flush_replies_locked( boost::system::error_code& ec );
+    void _send_com_port_command( uint8_t nCommand, const uint8_t* pValue, size_t nSize, boost::system::error_code& ec );
+
+    // IAC-escaped copy if needed, otherwise empty
+    static std::vector< uint8_t > _escape( const boost::asio::const_buffer* pBuffers, size_t nBuffers );
+
+private:
+    enum class EParserState { Data, Iac, Verb, Sb, SbIac };
+    EParserState m_state{ EParserState::Data };
+    uint8_t m_nVerb{ 0 };
+    std::vector< uint8_t > m_vSubnegotiation;
+
+    // Negotiation answers found by the reader, sent before the next read
+    std::mutex m_replies_mtx;
+    std::vector< uint8_t > m_vReplies;
+
+    // Serializes all the socket writes so the Telnet commands never land in the middle of the data
+    std::mutex m_write_mtx;
+    // An AsyncWrite() is on the socket, guarded by m_write_mtx. The blocking writes wait for it on m_write_cv
+    bool m_bAsyncWriteActive{ false };
+    std::condition_variable m_write_cv;
+
+    std::atomic< bool > m_bComPortAccepted{ false };
+    std::atomic< uint32_t > m_nServerBaud{ 0 };
+};
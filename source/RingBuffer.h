@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+// Fixed-capacity lock-free single-producer/single-consumer byte ring.
+// The producer is the reader thread (handle_read), the consumer is the thread waiting for data.
+// The producer never blocks: whatever does not fit is dropped and counted as overflow.
+class CSpscRingBuffer {
+public:
+    // Readable contents as up to two contiguous blocks (the second one is non-empty if the data wraps)
+    struct SSpans {
+        const uint8_t* pFirst{ nullptr };
+        size_t nFirst{ 0 };
+        const uint8_t* pSecond{ nullptr };
+        size_t nSecond{ 0 };
+
+        size_t size() const { return nFirst + nSecond; }
+    };
+
+    // Capacity is rounded up to a power of two
+    explicit CSpscRingBuffer( size_t nCapacity )
+        : m_nCapacity{ _round_up_pow2( nCapacity ) }
+        , m_nMask{ m_nCapacity - 1 }
+        , m_data( m_nCapacity )
+    {
+    }
+
+    size_t Capacity() const { return m_nCapacity; }
+
+    // Both sides
+    size_t Size() const
+    {
+        return m_head.load( std::memory_order_acquire ) - m_tail.load( std::memory_order_acquire );
+    }
+
+    uint64_t GetOverflowCount() const { return m_nOverflow.load( std::memory_order_relaxed ); }
+
+    // Producer side. Returns the number of bytes stored, the rest is dropped
+    size_t Write( const uint8_t* pData, size_t nSize )
+    {
+        if( 0 == nSize ) {
+            return 0;
+        }
+
+        const size_t nHead = m_head.load( std::memory_order_relaxed );
+        const size_t nTail = m_tail.load( std::memory_order_acquire );
+        const size_t nFree = m_nCapacity - ( nHead - nTail );
+
+        const size_t nToWrite = std::min( nFree, nSize );
+        if( nToWrite < nSize ) {
+            m_nOverflow.fetch_add( nSize - nToWrite, std::memory_order_relaxed );
+        }
+
+        const size_t nOffset = nHead & m_nMask;
+        const size_t nFirst = std::min( nToWrite, m_nCapacity - nOffset );
+        std::memcpy( m_data.data() + nOffset, pData, nFirst );
+        std::memcpy( m_data.data(), pData + nFirst, nToWrite - nFirst );
+
+        m_head.store( nHead + nToWrite, std::memory_order_release );
+        return nToWrite;
+    }
+
+    // Consumer side. Up to nMax readable bytes without copying. Valid until Consume()/Clear()
+    SSpans Peek( size_t nMax = SIZE_MAX ) const
+    {
+        const size_t nTail = m_tail.load( std::memory_order_relaxed );
+        const size_t nAvailable = std::min( m_head.load( std::memory_order_acquire ) - nTail, nMax );
+
+        const size_t nOffset = nTail & m_nMask;
+        SSpans spans;
+        spans.pFirst = m_data.data() + nOffset;
+        spans.nFirst = std::min( nAvailable, m_nCapacity - nOffset );
+        spans.pSecond = m_data.data();
+        spans.nSecond = nAvailable - spans.nFirst;
+        return spans;
+    }
+
+    // Consumer side. Releases the space of the first nSize readable bytes
+    void Consume( size_t nSize )
+    {
+        const size_t nTail = m_tail.load( std::memory_order_relaxed );
+        const size_t nAvailable = m_head.load( std::memory_order_acquire ) - nTail;
+        m_tail.store( nTail + std::min( nSize, nAvailable ), std::memory_order_release );
+    }
+
+    // Consumer side. Copies and consumes up to nSize bytes
+    size_t Read( uint8_t* pDest, size_t nSize )
+    {
+        SSpans spans = Peek( nSize );
+        std::memcpy( pDest, spans.pFirst, spans.nFirst );
+        std::memcpy( pDest + spans.nFirst, spans.pSecond, spans.nSecond );
+        Consume( spans.size() );
+        return spans.size();
+    }
+
+    // Consumer side. Drops everything received so far
+    void Clear()
+    {
+        m_tail.store( m_head.load( std::memory_order_acquire ), std::memory_order_release );
+    }
+
+private:
+    static size_t _round_up_pow2( size_t n )
+    {
+        size_t nResult{ 1 };
+        while( nResult < n ) {
+            nResult <<= 1;
+        }
+        return nResult;
+    }
+
+private:
+    const size_t m_nCapacity;
+    const size_t m_nMask;
+    std::vector< uint8_t > m_data;
+
+    // Monotonic positions, the index in m_data is ( position & m_nMask )
+    alignas( 64 ) std::atomic< size_t > m_head{ 0 };
+    alignas( 64 ) std::atomic< size_t > m_tail{ 0 };
+    alignas( 64 ) std::atomic< uint64_t > m_nOverflow{ 0 };
+};
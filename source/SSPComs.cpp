@@ -11,6 +11,8 @@
 #include "Encryption.h"
 #include "serialfunc.h"
 #include "ITLSSPProc.h"
+#include "SSPFixedFrames.h"
+#include "SSPFrameEncoder.h"
 #include "strings.hpp"
 
 namespace {
@@ -19,6 +21,28 @@ namespace {
 
     std::mutex g_command_mtx;
     std::chrono::steady_clock::time_point g_last_time_sent_cmd;
+
+    // Reply assembly for the ports without the frame decoder (not opened by OpenSSPPort()): byte by byte via SSPDataIn()
+    bool _read_reply_bytes( const SSP_PORT_WP& port, SSP_TX_RX_PACKET* ss, uint32_t nTimeoutMs )
+    {
+        unsigned char buffer;
+        auto startTime = std::chrono::steady_clock::now();
+        while( !ss->NewResponse ) {
+
+            auto nElapsed = static_cast< uint32_t >( std::chrono::duration_cast< std::chrono::milliseconds >( std::chrono::steady_clock::now() - startTime ).count() );
+            if( nElapsed >= nTimeoutMs || port.expired() ) {
+                return false;
+            }
+
+            if( ReadSingleByte( port, &buffer, nTimeoutMs - nElapsed, false ) == 0 ) {
+                continue;
+            }
+
+            // Append next byte to buffer and check if we have a complete packet (ss->NewResponse will be set to 1)
+            SSPDataIn( buffer, ss );
+        }
+        return true;
+    }
 }
 void _itl_ssp_set_last_time_sent_cmd( )
 {
@@ -37,15 +61,8 @@ extern unsigned char sspSeq[MAX_SSP_PORT];
 int CompileSSPCommand(SSP_COMMAND* cmd,SSP_TX_RX_PACKET* ss)
 {
 
-	int i,j;
-	unsigned short crc;
-	unsigned char tBuffer[255];
-
+	/* the receive buffer is not cleared: only the bytes below rxPtr are ever read  */
 	ss->rxPtr = 0;
-	for(i = 0; i < 255; i++)
-		ss->rxData[i] = 0x00;
-
-
 
 	/* for sync commands reset the deq bit   */
 	if(cmd->CommandData[0] == SSP_CMD_SYNC)
@@ -60,6 +77,21 @@ int CompileSSPCommand(SSP_COMMAND* cmd,SSP_TX_RX_PACKET* ss)
     }
 
 
+	ss->CheckStuff = 0;
+	ss->SSPAddress = cmd->SSPAddress;
+	ss->rxPtr = 0;
+	ss->txPtr = 0;
+
+	/* unencrypted commands without data are sent from the precompiled frames  */
+	if(!cmd->EncryptionStatus && cmd->CommandDataLength == 1){
+		const SSspFixedFrame* frame = SSPFindFixedFrame(cmd->CommandData[0],cmd->SSPAddress | sspSeq[cmd->SSPAddress]);
+		if(frame){
+			std::copy(frame->data,frame->data + frame->length,ss->txData);
+			ss->txBufferLength = frame->length;
+			return 1;
+		}
+	}
+
 	/* is this a encrypted packet  */
 	if(cmd->EncryptionStatus){
 
@@ -68,35 +100,11 @@ int CompileSSPCommand(SSP_COMMAND* cmd,SSP_TX_RX_PACKET* ss)
 	}
 
 	/* create the packet from this data   */
-	ss->CheckStuff = 0;
-	ss->SSPAddress = cmd->SSPAddress;
-	ss->rxPtr = 0;
-	ss->txPtr = 0;
-	ss->txBufferLength = cmd->CommandDataLength + 5;  /* the full ssp packet length   */
-	ss->txData[0] = SSP_STX;					/* ssp packet start   */
-	ss->txData[1] = cmd->SSPAddress | sspSeq[cmd->SSPAddress];  /* the address/seq bit */
-	ss->txData[2] = cmd->CommandDataLength;    /* the data length only (always > 0)  */
-	for(i = 0; i < cmd->CommandDataLength; i++)  /* add the command data  */
-		ss->txData[3 + i] = cmd->CommandData[i];
-	/* calc the packet CRC  (all bytes except STX)   */
-	crc = cal_crc_loop_CCITT_A(ss->txBufferLength - 3,&ss->txData[1] ,CRC_SSP_SEED,CRC_SSP_POLY);
-	ss->txData[3 + cmd->CommandDataLength] = (unsigned char)(crc & 0xFF);
-	ss->txData[4 + cmd->CommandDataLength] = (unsigned char)((crc >> 8) & 0xFF);
-
-
-	/* we now need to 'byte stuff' this buffered data   */
-	j = 0;
-	tBuffer[j++] = ss->txData[0];
-	for(i = 1; i < ss->txBufferLength; i++){
-		tBuffer[j] = ss->txData[i];
-		if (ss->txData[i] ==	SSP_STX){
-			tBuffer[++j] = SSP_STX;   /* SSP_STX found in data so add another to 'stuff it'  */
-		}
-		j++;
-	}
-	for(i = 0; i < j; i++)
-		ss->txData[i] = tBuffer[i];
-	ss->txBufferLength  = j;
+	/* header, data, CRC and byte stuffing in one pass straight into txData  */
+	CSSPFrameEncoder encoder(cmd->SSPAddress | sspSeq[cmd->SSPAddress],cmd->CommandData,cmd->CommandDataLength);
+	if(encoder.Encode(ss->txData,sizeof(ss->txData)) == 0)
+		return 0;   /* the stuffed packet does not fit  */
+	ss->txBufferLength = static_cast< unsigned char >(encoder.EncodedSize());
 
 	return 1;
 }
@@ -113,6 +121,8 @@ Notes:
     In the ssp_command structure:
     EncryptionStatus,SSPAddress,Timeout,RetryLevel,CommandData,CommandDataLength (and Key if using encrpytion) must be set before calling this function
     ResponseStatus,ResponseData,ResponseDataLength will be altered by this function call.
+    Timing is filled for the last attempt. Time points not reached (e.g. no reply) are left default constructed.
+    The reply is taken from the port's frame decoder; ports with frame decoding disabled are read byte by byte.
 */
 int  SSPSendCommand( const SSP_PORT_WP& port, SSP_COMMAND* cmd)
 {
@@ -127,7 +137,6 @@ int  SSPSendCommand( const SSP_PORT_WP& port, SSP_COMMAND* cmd)
 	int i;
 	unsigned char encryptLength;
 	unsigned short crcR;
-	unsigned char buffer;
 	unsigned char tData[255];
 	unsigned char retry;
 	unsigned int slaveCount;
@@ -148,7 +157,9 @@ int  SSPSendCommand( const SSP_PORT_WP& port, SSP_COMMAND* cmd)
         }
 
         ssp.NewResponse = 0;  /* set flag to wait for a new reply from slave   */
-        if( WriteData( ssp.txData, ssp.txBufferLength, port, true ) == 0 )
+        cmd->Timing = SSP_COMMAND_TIMING{};
+        cmd->Timing.TxStart = std::chrono::steady_clock::now();
+        if( WriteData( ssp.txData, ssp.txBufferLength, port, true, cmd->Timing.TxDrained ) == 0 )
         {
             if( g_commLogger ) {
                 g_commLogger( L"Failed to write data", false );
@@ -157,24 +168,26 @@ int  SSPSendCommand( const SSP_PORT_WP& port, SSP_COMMAND* cmd)
             return 0;
         }
 
-        /* wait for out reply */
+        /* wait for out reply. The frame is assembled and CRC checked by the port reader */
         cmd->ResponseStatus = SSP_REPLY_OK;
-        auto startTime = std::chrono::steady_clock::now();
-        while( !ssp.NewResponse ) {
-
-            auto tNow = std::chrono::steady_clock::now();
-            if( ( tNow - startTime ) >= std::chrono::milliseconds{ cmd->Timeout } ) {
-                if( g_commLogger ) {
-                    g_commLogger( L"No reply Timeout ", false );
-                }
-                cmd->ResponseStatus = SSP_CMD_TIMEOUT;
-                break;
+        SSspFrame frame;
+        boost::system::error_code ec;
+        if( ReadFrame( port, ssp.SSPAddress, frame, cmd->Timeout, ec ) ) {
+            cmd->Timing.RxFirstByte = frame.tFirstByte;
+            cmd->Timing.RxLastByte = frame.tLastByte;
+            cmd->Timing.Delivered = std::chrono::steady_clock::now();
+            std::copy( frame.data, frame.data + frame.length, ssp.rxData );
+            ssp.rxBufferLength = frame.length;
+            ssp.NewResponse = 1;
+        } else if( ec == boost::asio::error::operation_not_supported && _read_reply_bytes( port, &ssp, cmd->Timeout ) ) {
+            // No reader side time stamps in byte mode
+            cmd->Timing.Delivered = std::chrono::steady_clock::now();
+        } else {
+            if( g_commLogger ) {
+                // A corrupted reply is retried at once, not after the timeout
+                g_commLogger( ec == boost::system::errc::bad_message ? L"Corrupted reply" : L"No reply Timeout ", false );
             }
-
-            ReadSingleByte( port, &buffer, cmd->Timeout - std::chrono::duration_cast< std::chrono::milliseconds >( tNow - startTime ).count(), false );
-
-            // Append next byte to buffer and check if we have a complete packet (ssp.NewResponse will be set to 1)
-            SSPDataIn( buffer, &ssp );
+            cmd->ResponseStatus = SSP_CMD_TIMEOUT;
         }
 
         if(cmd->ResponseStatus == SSP_REPLY_OK)
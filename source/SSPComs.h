@@ -4,7 +4,12 @@
 
 #include "itl_types.h"
 #include "ssp_defines.h"
+#include "LibraryThread.h"
+#include <chrono>
 #include <functional>
+#include <map>
+#include <string>
+#include <vector>
 
 
 // Setting the outer logger for the comm subsystem
@@ -12,6 +17,29 @@ using _itl_ssp_logger_functor_t = std::function< void ( const std::wstring& strL
 void _itl_ssp_set_logger( _itl_ssp_logger_functor_t fn );
 void _itl_ssp_set_last_time_sent_cmd( void );
 
+// Number of threads servicing all the opened ports (see CSerialPortManager). Default is 1
+void _itl_ssp_set_io_threads_count( size_t nThreads );
+
+// Opt-in low latency tty profile for the ports opened by OpenSSPPort() afterwards.
+// See CThreadedSerialPort::SetLowLatencyProfile(), the applied settings are reported by GetLowLatencyState()
+void _itl_ssp_set_low_latency_profile( bool bEnable );
+
+// Echo suppression for the ports opened by OpenSSPPort() afterwards, for the RS-485 converters which echo
+// the transmitted bytes back. See CThreadedSerialPort::SetEchoSuppression(), counted by GetEchoStatistics()
+void _itl_ssp_set_echo_suppression( bool bEnable );
+
+// Affinity, scheduling class, stack size and name of the threads the library creates: the I/O threads
+// (the asio pool and the epoll / io_uring reactors), the firmware download and the discovery probes
+// (see CLibraryThread). The running threads of the role are changed at once, the stack size applies from
+// the next start. The effective settings are reported per thread
+void _itl_ssp_set_thread_attributes( EThreadRole eRole, const SThreadAttributes& attributes );
+std::vector< SThreadState > _itl_ssp_get_thread_states( void );
+
+// Implementation of the serial ports opened by OpenSSPPort() afterwards: boost::asio (default),
+// the native epoll/termios backend or io_uring, which falls back to epoll on the kernels without it.
+// See CTransport::ESerialBackend
+void _itl_ssp_set_serial_backend( CTransport::ESerialBackend eBackend );
+
 #define MAX_SSP_PORT 200
 
 #define NO_ENCRYPTION 0
@@ -35,6 +63,16 @@ typedef struct{
 	unsigned char PacketData[255];
 }SSP_PACKET;
 
+/* when the last SSPSendCommand attempt happened, steady clock. RxFirstByte - TxDrained is the device turnaround,
+   TxDrained - TxStart the wire time of the command, Delivered - RxLastByte the host overhead */
+typedef struct{
+	std::chrono::steady_clock::time_point TxStart;      /* the packet is handed to the port */
+	std::chrono::steady_clock::time_point TxDrained;    /* the last byte leaves the UART, estimated from the output queue */
+	std::chrono::steady_clock::time_point RxFirstByte;  /* the reply STX arrived */
+	std::chrono::steady_clock::time_point RxLastByte;   /* the reply is complete */
+	std::chrono::steady_clock::time_point Delivered;    /* the reply is handed to the caller */
+}SSP_COMMAND_TIMING;
+
 typedef struct{
 	SSP_FULL_KEY Key;
 	unsigned long BaudRate;
@@ -49,6 +87,7 @@ typedef struct{
 	unsigned char ResponseDataLength;
 	unsigned char ResponseData[255];
 	unsigned char IgnoreError;
+	SSP_COMMAND_TIMING Timing;
 }SSP_COMMAND;
 
 typedef struct{
@@ -141,6 +180,7 @@ Notes:
     In the ssp_command structure:
     EncryptionStatus,SSPAddress,Timeout,RetryLevel,CommandData,CommandDataLength (and Key if using encrpytion) must be set before calling this function
     ResponseStatus,ResponseData,ResponseDataLength will be altered by this function call.
+    Timing is filled for the last attempt. Time points not reached (e.g. no reply) are left default constructed.
 */
 int  SSPSendCommand( const SSP_PORT_WP&,SSP_COMMAND* cmd);
 
@@ -154,6 +194,48 @@ Notes:
 */
 SSP_PORT OpenSSPPort(const char * port);
 
+/*
+Name: OpenSSPPorts
+Inputs:
+    std::vector< std::string > vPorts: The names of the ports to open
+Return:
+    The port handles in the order of vPorts, an empty handle for each port that failed to open
+Notes:
+    The ports are opened concurrently (one EThreadRole::Discovery thread each), so opening many
+    ports takes about as long as opening the slowest one
+*/
+std::vector< SSP_PORT > OpenSSPPorts( const std::vector< std::string >& vPorts );
+
+typedef struct {
+    std::vector< std::string > Ports;           // empty: every /dev/ttyUSB* and /dev/ttyACM*
+    std::vector< uint32_t > BaudRates{ 9600 };  // tried in order, the first one a port answers at wins
+    std::vector< unsigned char > SSPAddresses{ 0, 16 };
+    unsigned long Timeout{ 500 };               // per command, milliseconds
+}SSP_DISCOVERY_SETUP;
+
+typedef struct {
+    uint32_t BaudRate;
+    unsigned char SSPAddress;
+    unsigned long Serial;
+    unsigned char UnitType;
+}SSP_DISCOVERED_DEVICE;
+
+/*
+Name: DiscoverSSPDevices
+Inputs:
+    SSP_DISCOVERY_SETUP setup: The candidate ports, baud rates and ssp addresses to probe
+Return:
+    The devices found, keyed by port name. Ports with no device are not listed
+Notes:
+    All the ports are probed in parallel, so the whole sweep takes about as long as the slowest port.
+    Within a port SSP_CMD_SYNC is sent to all the addresses at once and the replies are collected for one
+    Timeout per baud rate. If units sharing a bus garble each other's replies, the addresses that did not
+    answer are probed again one at a time, one Timeout each.
+    The responding units are then asked for their serial number and unit type.
+    The probed ports must not be opened elsewhere meanwhile
+*/
+std::map< std::string, std::vector< SSP_DISCOVERED_DEVICE > > DiscoverSSPDevices( const SSP_DISCOVERY_SETUP& setup );
+
 /*
 Name: CloseSSPPort
 Inputs:
@@ -349,6 +431,25 @@ Notes:
 */
 SSP_RESPONSE_ENUM ssp_sync(SSP_COMMAND_SETUP setup);
 
+/*
+Name:   ssp_set_baud_rate
+Inputs:
+    SSP_COMMAND_SETUP setup: The ssp setup structure used to setup the command
+    unsigned long baud: The operational baud rate wanted: 9600, 38400 or 115200
+    unsigned long * effective_baud: Set to the baud rate the port runs at on return
+Return:
+    SSP_RESPONSE_OK if the unit and the port switched and a SYNC round trip at the new rate succeeded
+    SSP_RESPONSE_FAILURE if the verification failed and the unit answers at the old rate again
+    SSP_RESPONSE_BAUD_RATE_UNKNOWN if the unit acknowledged the switch but answers at neither rate. The port
+    is back at the old rate; a reset of the unit or trying the other rates is required to talk to it again
+    On failure any other valid SSP_RESPONSE_ENUM value may be returned
+Notes:
+    SYNC, then SSP_CMD_SET_BAUD_RATE at the current rate. The new rate is verified with up to 3 SYNCs. The unit keeps the new rate until it resets,
+    so the negotiation is to be repeated after a reset or a reconnect (the port reopens at the last rate).
+    The large replies (ssp_get_all_levels, polls with many events) take a fraction of the 9600 baud time
+*/
+SSP_RESPONSE_ENUM ssp_set_baud_rate(SSP_COMMAND_SETUP setup, const unsigned long baud, unsigned long * effective_baud);
+
 /*
 Name:   ssp_disable
 Inputs:
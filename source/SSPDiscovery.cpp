@@ -0,0 +1,168 @@
+#include <algorithm>
+#include <future>
+#include <glob.h>
+#include "SSPComs.h"
+#include "Encryption.h"
+#include "ssp_defines.h"
+#include "LibraryThread.h"
+#include "SSPFixedFrames.h"
+
+namespace {
+    const unsigned char SEQ_BIT = 0x80;
+
+    // The discovery keeps its own sequence bits and does not touch the ones of the ports opened with OpenSSPPort().
+    // All its probes are single byte commands with precompiled frames
+    const SSspFixedFrame& _probe_frame( unsigned char nAddress, unsigned char nSeq, unsigned char nCommand )
+    {
+        return *SSPFindFixedFrame( nCommand, static_cast< unsigned char >( nAddress | nSeq ) );
+    }
+
+    // An OK reply carrying at least nDataLength bytes (the OK byte included) within the frame
+    bool _is_ok_reply( const SSspFrame& reply, unsigned char nDataLength )
+    {
+        return reply.length >= 3 && reply.data[ 2 ] >= nDataLength && reply.length >= reply.data[ 2 ] + 5
+               && reply.data[ 3 ] == SSP_RESPONSE_OK;
+    }
+
+    bool _transact( CThreadedSerialPort& port, unsigned char nAddress, unsigned char nSeq, unsigned char nCommand, unsigned long nTimeoutMs,
+                    unsigned char nDataLength, SSspFrame& reply )
+    {
+        const SSspFixedFrame& frame = _probe_frame( nAddress, nSeq, nCommand );
+        if( !port.Write( frame.data, frame.length, true ) ) {
+            return false;
+        }
+        boost::system::error_code ec;
+        return port.WaitForFrame( nAddress, std::chrono::steady_clock::now() + std::chrono::milliseconds( nTimeoutMs ), reply, ec )
+               && _is_ok_reply( reply, nDataLength );
+    }
+
+    std::vector< SSP_DISCOVERED_DEVICE > _probe_port( const std::string& strPort, const SSP_DISCOVERY_SETUP& setup )
+    {
+        std::vector< SSP_DISCOVERED_DEVICE > vDevices;
+        if( setup.BaudRates.empty() || setup.SSPAddresses.empty() ) {
+            return vDevices;
+        }
+
+        CThreadedSerialPort port( strPort, setup.BaudRates.front(),
+                                  boost::asio::serial_port_base::parity::none,
+                                  8, boost::asio::serial_port_base::stop_bits::two );
+        if( !port.Open( false ) || !port.IsOpen() ) {
+            return vDevices;
+        }
+        port.EnableFrameDecoding( true );
+        port.StartThread( false );
+
+        for( auto nBaud : setup.BaudRates ) {
+            if( !port.SetBaudrate( nBaud ) ) {
+                break;
+            }
+
+            // All the SYNC packets of a sweep go out in one write and the replies are collected for one timeout
+            std::vector< boost::asio::const_buffer > vSync;
+            for( auto nAddress : setup.SSPAddresses ) {
+                const SSspFixedFrame& frame = _probe_frame( nAddress, SEQ_BIT, SSP_CMD_SYNC );
+                vSync.emplace_back( frame.data, frame.length );
+            }
+            const CSSPFrameDecoder::SStatistics before = port.GetFrameStatistics().decoder;
+            if( !port.Write( vSync.data(), vSync.size(), true ) ) {
+                break;
+            }
+
+            std::vector< unsigned char > vResponding;
+            SSspFrame reply;
+            bool bGarbled{ false };
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds( setup.Timeout );
+            while( vResponding.size() < setup.SSPAddresses.size() ) {
+                boost::system::error_code ec;
+                if( !port.WaitForFrame( CThreadedSerialPort::ANY_ADDRESS, deadline, reply, ec ) ) {
+                    if( ec == boost::system::errc::bad_message ) {
+                        bGarbled = true;
+                        continue;
+                    }
+                    break;
+                }
+                const unsigned char nAddress = reply.Address();
+                if(    _is_ok_reply( reply, 1 )
+                    && std::find( setup.SSPAddresses.begin(), setup.SSPAddresses.end(), nAddress ) != setup.SSPAddresses.end()
+                    && std::find( vResponding.begin(), vResponding.end(), nAddress ) == vResponding.end() ) {
+                    vResponding.push_back( nAddress );
+                }
+            }
+
+            // Units sharing a bus answered at once and garbled each other's replies:
+            // the addresses still silent are probed again one at a time
+            const CSSPFrameDecoder::SStatistics after = port.GetFrameStatistics().decoder;
+            bGarbled = bGarbled || after.nCrcErrors != before.nCrcErrors || after.nFalseStarts != before.nFalseStarts
+                       || after.nDiscardedBytes != before.nDiscardedBytes;
+            if( bGarbled ) {
+                for( auto nAddress : setup.SSPAddresses ) {
+                    if(    std::find( vResponding.begin(), vResponding.end(), nAddress ) == vResponding.end()
+                        && _transact( port, nAddress, SEQ_BIT, SSP_CMD_SYNC, setup.Timeout, 1, reply ) ) {
+                        vResponding.push_back( nAddress );
+                    }
+                }
+            }
+            if( vResponding.empty() ) {
+                continue;
+            }
+
+            // Synchronised: the next packets are sent with the sequence bit cleared, then set
+            for( auto nAddress : vResponding ) {
+                SSP_DISCOVERED_DEVICE device{};
+                device.BaudRate = nBaud;
+                device.SSPAddress = nAddress;
+                if( _transact( port, nAddress, 0, SSP_CMD_SERIAL_NUMBER, setup.Timeout, 5, reply ) ) {
+                    for( int i = 0; i < 4; ++i ) {
+                        device.Serial += static_cast< unsigned long >( reply.data[ 4 + i ] ) << ( 8 * ( 3 - i ) );
+                    }
+                }
+                if( _transact( port, nAddress, SEQ_BIT, SSP_CMD_UNIT_DATA, setup.Timeout, 2, reply ) ) {
+                    device.UnitType = reply.data[ 4 ];
+                }
+                vDevices.push_back( device );
+            }
+            break;
+        }
+
+        port.StopThread();
+        return vDevices;
+    }
+
+    std::vector< std::string > _default_candidates()
+    {
+        std::vector< std::string > vPorts;
+        for( const char* szPattern : { "/dev/ttyUSB*", "/dev/ttyACM*" } ) {
+            glob_t g{};
+            if( 0 == ::glob( szPattern, 0, nullptr, &g ) ) {
+                for( size_t i = 0; i < g.gl_pathc; ++i ) {
+                    vPorts.emplace_back( g.gl_pathv[ i ] );
+                }
+            }
+            ::globfree( &g );
+        }
+        return vPorts;
+    }
+}
+
+std::map< std::string, std::vector< SSP_DISCOVERED_DEVICE > > DiscoverSSPDevices( const SSP_DISCOVERY_SETUP& setup )
+{
+    std::vector< std::string > vPorts = setup.Ports.empty() ? _default_candidates() : setup.Ports;
+
+    // One prober per port, all the ports are multiplexed onto the shared reactor
+    std::vector< std::future< std::vector< SSP_DISCOVERED_DEVICE > > > vProbes;
+    std::vector< CLibraryThread > vThreads;
+    for( const auto& strPort : vPorts ) {
+        std::packaged_task< std::vector< SSP_DISCOVERED_DEVICE >() > probe( [ &strPort, &setup ] { return _probe_port( strPort, setup ); } );
+        vProbes.push_back( probe.get_future() );
+        vThreads.emplace_back( EThreadRole::Discovery, std::move( probe ) );
+    }
+
+    std::map< std::string, std::vector< SSP_DISCOVERED_DEVICE > > result;
+    for( size_t i = 0; i < vPorts.size(); ++i ) {
+        auto vDevices = vProbes[ i ].get();
+        if( !vDevices.empty() ) {
+            result[ vPorts[ i ] ] = std::move( vDevices );
+        }
+    }
+    return result;
+}
@@ -10,6 +10,7 @@
 #include "Encryption.h"
 #include "SSPComs.h"
 #include "serialfunc.h"
+#include "LibraryThread.h"
 #include "ssp_defines.h"
 
 namespace {
@@ -171,9 +172,10 @@ uint32_t DownloadFileToTarget(const char * file, const char * port, const unsign
 
 uint8_t _read_single_byte_reply( ITL_FILE_DOWNLOAD* itlFile, const uint32_t timeout)
 {
-    auto result = itlFile->port->WaitForIncomingData( 1, timeout, false );
-    if( result.first == true ) {
-        return result.second[ 0 ];
+    uint8_t nReply{ 0 };
+    boost::system::error_code ec;
+    if( itlFile->port->WaitForIncomingData( &nReply, 1, timeout, ec, false ) == 1 ) {
+        return nReply;
     }
 
     return -1;
@@ -232,6 +234,9 @@ uint32_t ___download_ram_file(ITL_FILE_DOWNLOAD * itlFile, SSP_COMMAND * sspC)
 		}
 		if(baud == 0) baud = 38400;
 	}
+    // From now on the target talks the raw download protocol rather than SSP frames
+    itlFile->port->EnableFrameDecoding( false );
+
 	SetBaud(itlFile->port,baud);
     itlFile->baud = baud;
 
@@ -239,14 +244,21 @@ uint32_t ___download_ram_file(ITL_FILE_DOWNLOAD * itlFile, SSP_COMMAND * sspC)
 
     numRamBlocks = itlFile->NumberOfRamBytes/RAM_DWNL_BLOCK_SIZE;
 
-    for( i = 0; i < numRamBlocks; i++ ) {
+    // Clear rx accumulator before writing the first block
+    itlFile->port->PurgeRxBuffer();
 
-        // Clear rx accumulator before writing the first block
-        WriteData( &itlFile->data[ 128 + ( i * RAM_DWNL_BLOCK_SIZE ) ], RAM_DWNL_BLOCK_SIZE, itlFile->port, i == 0 );
+    // The blocks are queued at once and coalesced by the port. Only wait for the last one to be sent
+    std::future< CThreadedSerialPort::SWriteCompletion > lastBlock;
+    for( i = 0; i < numRamBlocks; i++ ) {
+        lastBlock = itlFile->port->AsyncWrite( &itlFile->data[ 128 + ( i * RAM_DWNL_BLOCK_SIZE ) ], RAM_DWNL_BLOCK_SIZE );
 	}
 
     if( ( itlFile->NumberOfRamBytes % RAM_DWNL_BLOCK_SIZE ) !=  0 ) {
-        WriteData( &itlFile->data[ 128 + ( i * RAM_DWNL_BLOCK_SIZE ) ], itlFile->NumberOfRamBytes % RAM_DWNL_BLOCK_SIZE, itlFile->port, false );
+        lastBlock = itlFile->port->AsyncWrite( &itlFile->data[ 128 + ( i * RAM_DWNL_BLOCK_SIZE ) ], itlFile->NumberOfRamBytes % RAM_DWNL_BLOCK_SIZE );
+    }
+
+    if( lastBlock.valid() && lastBlock.get().ec ) {
+        return DATA_TRANSFER_FAIL;
     }
 
     buffer = _read_single_byte_reply( itlFile, 500 );
@@ -278,6 +290,7 @@ uint32_t ___download_main_file( ITL_FILE_DOWNLOAD* itlFile)
     if( !itlFile->port ) {
         return PORT_OPEN_FAIL;
     }
+    itlFile->port->EnableFrameDecoding( false );
     SetBaud(itlFile->port,itlFile->baud);
 
     if (_send_download_command( &itlFile->data[6], 1, ram_OK_ACK, itlFile ) == 0)
@@ -293,8 +306,13 @@ uint32_t ___download_main_file( ITL_FILE_DOWNLOAD* itlFile)
         for(i = 0; i < itlFile->dwnlBlockSize; ++i) {
             chk ^= itlFile->data[block_offset + i];
         }
-        WriteData( &itlFile->data[ block_offset ], itlFile->dwnlBlockSize, itlFile->port, false );
-        if( _send_download_command( &chk, 1, chk, itlFile ) == 0 )
+        // The block and its checksum go out in one gather write straight from the file image
+        const boost::asio::const_buffer block[] = {
+            { &itlFile->data[ block_offset ], itlFile->dwnlBlockSize },
+            { &chk, 1 }
+        };
+        WriteDataV( block, 2, itlFile->port, false );
+        if( _read_single_byte_reply( itlFile, 5000 ) != chk )
             return DATA_TRANSFER_FAIL;
 
         download_block = cur_block;
@@ -332,7 +350,8 @@ uint32_t __downloadITLTarget( std::unique_ptr< ITL_FILE_DOWNLOAD > itlFile )
     return_value = ___download_ram_file( itlFile.get(), &sspC );
     if( return_value == DOWNLOAD_COMPLETE ) {
 
-        std::thread _abandoned{
+        CLibraryThread _abandoned{
+            EThreadRole::Download,
             [ itlParam = std::move( itlFile ) ]
             {
                 ___download_main_file( itlParam.get() );
@@ -341,7 +360,7 @@ uint32_t __downloadITLTarget( std::unique_ptr< ITL_FILE_DOWNLOAD > itlFile )
                 download_block = DOWNLOAD_COMPLETE;
             }
         };
-        _abandoned.detach();
+        _abandoned.Detach();
         return DOWNLOAD_STARTED;
     } else {
         CloseSSPPort( itlFile->port );
@@ -0,0 +1,85 @@
+#include "SSPFixedFrames.h"
+#include <array>
+#include <cstddef>
+#include "Crc16.h"
+#include "Encryption.h"
+#include "ssp_defines.h"
+
+namespace {
+    // The commands the library sends with no data
+    constexpr uint8_t FIXED_COMMANDS[] = {
+        SSP_CMD_RESET, SSP_CMD_BULB_ON, SSP_CMD_BULB_OFF, SSP_CMD_SETUP_REQUEST, SSP_CMD_POLL,
+        SSP_CMD_REJECT_NOTE, SSP_CMD_DISABLE, SSP_CMD_ENABLE, SSP_CMD_SERIAL_NUMBER, SSP_CMD_UNIT_DATA,
+        SSP_CMD_CHANNEL_VALUES, SSP_CMD_CHANNEL_SECURITY, SSP_CMD_SYNC, SSP_CMD_LAST_REJECT, SSP_CMD_HOLD,
+        SSP_CMD_ENABLE_HIGHER_PROTOCOL, SSP_CMD_GET_ALL_LEVELS, SSP_CMD_HALT_PAYOUT, SSP_CMD_EMPTY,
+        SSP_CMD_ENABLE_PAYOUT_DEVICE, SSP_CMD_DISABLE_PAYOUT_DEVICE, SSP_CMD_SMART_EMPTY,
+        SSP_CMD_CASHBOX_PAYOUT_OPERATION_DATA
+    };
+    constexpr size_t FIXED_COMMANDS_COUNT = sizeof( FIXED_COMMANDS ) / sizeof( FIXED_COMMANDS[ 0 ] );
+
+    using frames_t = std::array< SSspFixedFrame, 256 >;
+
+    constexpr uint16_t _crc( const uint8_t* p, size_t n )
+    {
+        uint16_t crc = CRC_SSP_SEED;
+        for( size_t i = 0; i < n; ++i ) {
+            crc ^= static_cast< uint16_t >( p[ i ] << 8 );
+            for( int j = 0; j < 8; ++j ) {
+                crc = static_cast< uint16_t >( ( crc & 0x8000 ) ? ( crc << 1 ) ^ CCrc16::POLY : crc << 1 );
+            }
+        }
+        return crc;
+    }
+
+    constexpr SSspFixedFrame _make_frame( uint8_t nCommand, uint8_t nSeqAddress )
+    {
+        uint8_t packet[ 5 ] = { nSeqAddress, 1, nCommand, 0, 0 };
+        const uint16_t crc = _crc( packet, 3 );
+        packet[ 3 ] = static_cast< uint8_t >( crc & 0xFF );
+        packet[ 4 ] = static_cast< uint8_t >( ( crc >> 8 ) & 0xFF );
+
+        SSspFixedFrame frame{};
+        frame.data[ frame.length++ ] = SSP_STX;
+        for( uint8_t nByte : packet ) {
+            frame.data[ frame.length++ ] = nByte;
+            if( nByte == SSP_STX ) {
+                frame.data[ frame.length++ ] = SSP_STX;
+            }
+        }
+        return frame;
+    }
+
+    constexpr std::array< frames_t, FIXED_COMMANDS_COUNT > _make_frames()
+    {
+        std::array< frames_t, FIXED_COMMANDS_COUNT > frames{};
+        for( size_t c = 0; c < FIXED_COMMANDS_COUNT; ++c ) {
+            for( size_t n = 0; n < 256; ++n ) {
+                frames[ c ][ n ] = _make_frame( FIXED_COMMANDS[ c ], static_cast< uint8_t >( n ) );
+            }
+        }
+        return frames;
+    }
+
+    // Command byte to index in g_frames + 1, 0 for the commands with no precompiled frames
+    constexpr std::array< uint8_t, 256 > _make_slots()
+    {
+        std::array< uint8_t, 256 > slots{};
+        for( size_t c = 0; c < FIXED_COMMANDS_COUNT; ++c ) {
+            slots[ FIXED_COMMANDS[ c ] ] = static_cast< uint8_t >( c + 1 );
+        }
+        return slots;
+    }
+
+    constexpr std::array< frames_t, FIXED_COMMANDS_COUNT > g_frames = _make_frames();
+    constexpr std::array< uint8_t, 256 > g_slots = _make_slots();
+
+    // The SYNC to address 0 from the SSP specification: 7F 80 01 11 65 82
+    constexpr SSspFixedFrame g_sync = _make_frame( SSP_CMD_SYNC, 0x80 );
+    static_assert( g_sync.length == 6 && g_sync.data[ 4 ] == 0x65 && g_sync.data[ 5 ] == 0x82, "SSP frame CRC" );
+}
+
+const SSspFixedFrame* SSPFindFixedFrame( uint8_t nCommand, uint8_t nSeqAddress )
+{
+    const uint8_t nSlot = g_slots[ nCommand ];
+    return nSlot != 0 ? &g_frames[ nSlot - 1 ][ nSeqAddress ] : nullptr;
+}
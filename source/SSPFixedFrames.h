@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+
+// Wire frame of a single byte command: STX, SEQ/ADDR, LEN = 1, command, CRCL, CRCH, byte stuffed.
+// At most 3 bytes get doubled: SEQ/ADDR 0x7F and the 2 CRC bytes
+struct SSspFixedFrame {
+    uint8_t data[ 9 ];
+    uint8_t length;
+};
+
+// The frames of the commands without arguments are built at compile time for every SEQ/ADDR byte,
+// so an unencrypted POLL, SYNC, ENABLE... needs no CRC or stuffing when sent.
+// Returns nullptr if nCommand is not one of them
+const SSspFixedFrame* SSPFindFixedFrame( uint8_t nCommand, uint8_t nSeqAddress );
@@ -0,0 +1,168 @@
+#include "SSPFrameDecoder.h"
+#include <cstring>
+#include "Encryption.h"
+#include "ssp_defines.h"
+#include "SSPStxScan.h"
+
+void CSSPFrameDecoder::Reset()
+{
+    m_nPtr = 0;
+    m_nExpectedLength = 0;
+    m_bCheckStuff = false;
+}
+
+size_t CSSPFrameDecoder::Feed( const uint8_t* pData, size_t nSize, const frame_handler_t& fnFrame, const SRxChunkTime& chunkTime )
+{
+    size_t nFrames{ 0 };
+
+    size_t i{ 0 };
+    while( i < nSize ) {
+        bool bResync{ false };
+        i = _decode( pData, nSize, i, fnFrame, chunkTime, nFrames, bResync );
+        if( bResync ) {
+            // The bytes of the failed frame from its hidden start on go first, then the rest of the chunk
+            _resync( chunkTime.characterTime );
+            _replay( fnFrame, nFrames );
+        }
+    }
+
+    return nFrames;
+}
+
+size_t CSSPFrameDecoder::_decode( const uint8_t* pData, size_t nSize, size_t i, const frame_handler_t& fnFrame, const SRxChunkTime& chunkTime,
+                                  size_t& nFrames, bool& bResync )
+{
+    while( i < nSize ) {
+
+        if( m_nPtr == 0 ) {
+            // Skip everything else but STX
+            const size_t nSkipped = SSPFindStx( pData + i, nSize - i );
+            m_stats.nDiscardedBytes += nSkipped;
+            i += nSkipped;
+            if( i == nSize ) {
+                break;
+            }
+            m_frame.data[ m_nPtr++ ] = SSP_STX;
+            m_frame.tFirstByte = chunkTime.At( i );
+            m_nExpectedLength = 0;
+            ++i;
+            continue;
+        }
+
+        if( m_bCheckStuff ) {
+            const uint8_t rxChar = pData[ i ];
+            // if last byte was STX and the next one is not then restart the packet
+            if( rxChar != SSP_STX ) {
+                ++m_stats.nFalseStarts;
+                m_stats.nDiscardedBytes += _raw_length( m_nPtr );
+                m_frame.data[ 0 ] = SSP_STX;
+                m_frame.data[ 1 ] = rxChar;
+                m_frame.tFirstByte = chunkTime.At( i > 0 ? i - 1 : 0 );
+                m_nPtr = 2;
+                m_nExpectedLength = 0;
+            } else {
+                m_frame.data[ m_nPtr++ ] = rxChar;
+            }
+            m_bCheckStuff = false;
+            ++i;
+        } else {
+            // The bytes up to the header or the frame end, whichever is next, in one go unless an STX
+            // comes first: either a stuffed STX or a new packet start, the byte after it decides
+            const size_t nNeeded = ( m_nExpectedLength != 0 ? m_nExpectedLength : 3u ) - m_nPtr;
+            const size_t nAvailable = std::min( nNeeded, nSize - i );
+            const size_t nRun = SSPFindStx( pData + i, nAvailable );
+            std::memcpy( &m_frame.data[ m_nPtr ], pData + i, nRun );
+            m_nPtr = static_cast< uint8_t >( m_nPtr + nRun );
+            i += nRun;
+            if( nRun < nAvailable ) {
+                m_bCheckStuff = true;
+                ++i;
+                continue;
+            }
+        }
+
+        if( m_nPtr == 3 && m_nExpectedLength == 0 ) {
+            // No frame has the doubled STX for SEQ/ADDR or no data: the STX was noise, maybe right before the real one
+            if( m_frame.data[ 1 ] == SSP_STX || m_frame.data[ 2 ] == 0 ) {
+                ++m_stats.nFalseStarts;
+                bResync = true;
+                return i;
+            }
+            m_nExpectedLength = static_cast< uint16_t >( m_frame.data[ 2 ] + 5 );
+            if( m_nExpectedLength > sizeof( m_frame.data ) ) {
+                // Does not fit any SSP packet
+                ++m_stats.nOversizeLengths;
+                bResync = true;
+                return i;
+            }
+        }
+
+        // are we at the end of the packet
+        if( m_nPtr >= 3 && m_nPtr == m_nExpectedLength ) {
+            auto crc = cal_crc_loop_CCITT_A( static_cast< short >( m_nExpectedLength - 3 ), &m_frame.data[ 1 ], CRC_SSP_SEED, CRC_SSP_POLY );
+            if(    static_cast< uint8_t >( crc & 0xFF ) == m_frame.data[ m_nExpectedLength - 2 ]
+                && static_cast< uint8_t >( ( crc >> 8 ) & 0xFF ) == m_frame.data[ m_nExpectedLength - 1 ] ) {
+
+                m_frame.length = static_cast< uint8_t >( m_nExpectedLength );
+                m_frame.tLastByte = chunkTime.At( i - 1 );
+                ++nFrames;
+                ++m_stats.nFrames;
+                fnFrame( m_frame );
+                Reset();
+            } else {
+                ++m_stats.nCrcErrors;
+                bResync = true;
+                return i;
+            }
+        }
+    }
+
+    return i;
+}
+
+size_t CSSPFrameDecoder::_raw_length( size_t nLength ) const
+{
+    // Every STX after the first one came doubled
+    return nLength > 1 ? nLength + SSPCountStx( &m_frame.data[ 1 ], nLength - 1 ) : nLength;
+}
+
+void CSSPFrameDecoder::_resync( std::chrono::nanoseconds characterTime )
+{
+    const size_t nLength = m_nPtr;
+    const size_t nStx = 1 + SSPFindStx( &m_frame.data[ 1 ], nLength - 1 );
+    if( nStx == nLength ) {
+        m_stats.nDiscardedBytes += _raw_length( nLength );
+        Reset();
+        return;
+    }
+
+    // The second byte of the doubled STX becomes the frame start, the bytes after it are stuffed back
+    const size_t nReplay = 1 + _raw_length( nLength ) - _raw_length( nStx + 1 );
+    size_t nPos = m_nReplayPos - nReplay;
+    m_replay[ nPos++ ] = SSP_STX;
+    for( size_t k = nStx + 1; k < nLength; ++k ) {
+        m_replay[ nPos++ ] = m_frame.data[ k ];
+        if( m_frame.data[ k ] == SSP_STX ) {
+            m_replay[ nPos++ ] = SSP_STX;
+        }
+    }
+    m_nReplayPos -= nReplay;
+
+    const size_t nDiscarded = _raw_length( nStx + 1 ) - 1;
+    m_stats.nDiscardedBytes += nDiscarded;
+    m_replayTime.characterTime = characterTime;
+    m_replayTime.tFirstByte = m_frame.tFirstByte + characterTime * static_cast< int64_t >( nDiscarded )
+                            - characterTime * static_cast< int64_t >( m_nReplayPos );
+    Reset();
+}
+
+void CSSPFrameDecoder::_replay( const frame_handler_t& fnFrame, size_t& nFrames )
+{
+    while( m_nReplayPos < sizeof( m_replay ) ) {
+        bool bResync{ false };
+        m_nReplayPos = _decode( m_replay, sizeof( m_replay ), m_nReplayPos, fnFrame, m_replayTime, nFrames, bResync );
+        if( bResync ) {
+            _resync( m_replayTime.characterTime );
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <chrono>
+#include <functional>
+
+// Complete SSP frame with byte stuffing removed: STX, SEQ/ADDR, LEN, DATA[LEN], CRCL, CRCH
+struct SSspFrame {
+    uint8_t data[255];
+    uint8_t length{ 0 };
+    // Arrival of the STX and of the last CRC byte, see SRxChunkTime
+    std::chrono::steady_clock::time_point tFirstByte;
+    std::chrono::steady_clock::time_point tLastByte;
+
+    uint8_t Address() const { return data[ 1 ] & 0x7F; }
+};
+
+// When the bytes of a received chunk arrived: the first one at tFirstByte, every next one
+// a character time later. A zero character time stamps the whole chunk with tFirstByte
+struct SRxChunkTime {
+    std::chrono::steady_clock::time_point tFirstByte;
+    std::chrono::nanoseconds characterTime{ 0 };
+
+    std::chrono::steady_clock::time_point At( size_t nOffset ) const { return tFirstByte + characterTime * static_cast< int64_t >( nOffset ); }
+};
+
+// Incremental SSP frame decoder. Runs the STX / byte stuffing / CRC state machine
+// over received chunks and reports every complete frame with a valid CRC.
+// The STX bytes are located with SIMD compares, the runs between them are copied in bulk.
+// A frame with an impossible header or failing the CRC is searched for a real frame start hidden behind
+// a false one (a noise STX right before the real one reads as a stuffed STX) and decoding resumes there
+// at once, not when the bytes the bogus LEN asks for have come.
+// Not thread safe: owned by the port reader.
+class CSSPFrameDecoder {
+public:
+    using frame_handler_t = std::function< void( const SSspFrame& ) >;
+
+    // Counters since the decoder creation, Reset() keeps them. The bytes are counted as received, stuffed
+    struct SStatistics {
+        uint64_t nFrames{ 0 };              // frames reported
+        uint64_t nDiscardedBytes{ 0 };      // bytes outside the reported frames: noise, failed and abandoned frames
+        uint64_t nFalseStarts{ 0 };         // STX which started no frame: restarted by another STX, SEQ/ADDR 0x7F or LEN 0
+        uint64_t nCrcErrors{ 0 };
+        uint64_t nOversizeLengths{ 0 };     // LEN too large for any SSP packet
+    };
+
+    void Reset();
+
+    // Returns the number of complete frames reported
+    size_t Feed( const uint8_t* pData, size_t nSize, const frame_handler_t& fnFrame, const SRxChunkTime& chunkTime = {} );
+
+    const SStatistics& GetStatistics() const { return m_stats; }
+
+private:
+    // Runs the state machine over pData from the index i until the end or a failed frame (bResync set),
+    // returns the index it stopped at
+    size_t _decode( const uint8_t* pData, size_t nSize, size_t i, const frame_handler_t& fnFrame, const SRxChunkTime& chunkTime,
+                    size_t& nFrames, bool& bResync );
+    // Number of received bytes the first nLength bytes of m_frame came from
+    size_t _raw_length( size_t nLength ) const;
+    // Drops the failed frame up to the next STX inside it, if any, and queues the rest for replay
+    void _resync( std::chrono::nanoseconds characterTime );
+    // Decodes the queued bytes, the replays they trigger included
+    void _replay( const frame_handler_t& fnFrame, size_t& nFrames );
+
+    SSspFrame m_frame;
+    uint8_t m_nPtr{ 0 };
+    uint16_t m_nExpectedLength{ 0 };
+    bool m_bCheckStuff{ false };
+    SStatistics m_stats;
+
+    // The bytes to replay are m_replay[m_nReplayPos..], queued from the end: a replay is always a suffix of
+    // the bytes received, so the one queued while replaying fits below the bytes still to replay.
+    // Byte k of the buffer is stamped m_replayTime.At( k )
+    uint8_t m_replay[ 2 * sizeof( SSspFrame::data ) ];
+    size_t m_nReplayPos{ sizeof( m_replay ) };
+    SRxChunkTime m_replayTime;
+};
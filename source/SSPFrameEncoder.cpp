@@ -0,0 +1,76 @@
+#include "SSPFrameEncoder.h"
+#include <cstring>
+#include "Crc16.h"
+#include "SSPStxScan.h"
+#include "ssp_defines.h"
+#include "Encryption.h"
+
+namespace {
+    const size_t SCAN_MIN_SIZE = 16;
+
+    inline uint8_t* _put_stuffed( uint8_t* pOut, uint8_t nByte )
+    {
+        *pOut++ = nByte;
+        if( nByte == SSP_STX ) {
+            *pOut++ = SSP_STX;
+        }
+        return pOut;
+    }
+
+    inline size_t _is_stx( uint8_t nByte )
+    {
+        return nByte == SSP_STX ? 1 : 0;
+    }
+}
+
+CSSPFrameEncoder::CSSPFrameEncoder( uint8_t nSeqAddress, const uint8_t* pData, uint8_t nLength )
+    : m_header{ nSeqAddress, nLength }
+    , m_pData{ pData }
+    , m_nLength{ nLength }
+{
+    // All the bytes but STX, header and data as one stream
+    const uint16_t crc = CCrc16::Compute( m_pData, m_nLength, CCrc16::Compute( m_header, sizeof( m_header ), CRC_SSP_SEED ) );
+    m_crc[ 0 ] = static_cast< uint8_t >( crc & 0xFF );
+    m_crc[ 1 ] = static_cast< uint8_t >( ( crc >> 8 ) & 0xFF );
+
+    m_nEncodedSize = 1 + sizeof( m_header ) + m_nLength + sizeof( m_crc )
+                   + _is_stx( m_header[ 0 ] ) + _is_stx( m_header[ 1 ] ) + SSPCountStx( m_pData, m_nLength )
+                   + _is_stx( m_crc[ 0 ] ) + _is_stx( m_crc[ 1 ] );
+}
+
+size_t CSSPFrameEncoder::Encode( uint8_t* pOut, size_t nOutSize ) const
+{
+    if( nOutSize < m_nEncodedSize ) {
+        return 0;
+    }
+
+    uint8_t* p = pOut;
+    *p++ = SSP_STX;
+    p = _put_stuffed( p, m_header[ 0 ] );
+    p = _put_stuffed( p, m_header[ 1 ] );
+
+    // The data in runs up to the next STX, which goes out doubled. Below a vector the bytes go one by one
+    const uint8_t* pData = m_pData;
+    size_t nLeft = m_nLength;
+    if( nLeft < SCAN_MIN_SIZE ) {
+        for( ; nLeft > 0; --nLeft ) {
+            p = _put_stuffed( p, *pData++ );
+        }
+    }
+    while( nLeft > 0 ) {
+        const size_t nRun = SSPFindStx( pData, nLeft );
+        std::memcpy( p, pData, nRun );
+        p += nRun;
+        if( nRun == nLeft ) {
+            break;
+        }
+        *p++ = SSP_STX;
+        *p++ = SSP_STX;
+        pData += nRun + 1;
+        nLeft -= nRun + 1;
+    }
+
+    p = _put_stuffed( p, m_crc[ 0 ] );
+    p = _put_stuffed( p, m_crc[ 1 ] );
+    return static_cast< size_t >( p - pOut );
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// SSP frame encoder: STX, SEQ/ADDR, LEN, DATA[LEN], CRCL, CRCH with every STX after the first one doubled.
+// The CRC and the exact encoded size are known once constructed, so the caller can size the output;
+// Encode() then writes header, data, CRC and stuffing in one pass. The data must outlive the encoder
+class CSSPFrameEncoder {
+public:
+    CSSPFrameEncoder( uint8_t nSeqAddress, const uint8_t* pData, uint8_t nLength );
+
+    size_t EncodedSize() const { return m_nEncodedSize; }
+
+    // Writes EncodedSize() bytes to pOut and returns that. Writes nothing and returns 0 if nOutSize is smaller
+    size_t Encode( uint8_t* pOut, size_t nOutSize ) const;
+
+private:
+    uint8_t m_header[ 2 ];
+    const uint8_t* m_pData;
+    uint8_t m_nLength;
+    uint8_t m_crc[ 2 ];
+    size_t m_nEncodedSize;
+};
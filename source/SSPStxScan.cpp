@@ -0,0 +1,128 @@
+#include "SSPStxScan.h"
+#include <cstring>
+#include "ssp_defines.h"
+
+#if defined( __x86_64__ )
+#include <immintrin.h>
+#elif defined( __aarch64__ )
+#include <arm_neon.h>
+#endif
+
+namespace {
+#if defined( __x86_64__ )
+
+    const bool g_bHasAvx2 = ( __builtin_cpu_init(), __builtin_cpu_supports( "avx2" ) );
+
+    inline unsigned _stx_mask_sse2( const uint8_t* p )
+    {
+        const __m128i stx = _mm_set1_epi8( static_cast< char >( SSP_STX ) );
+        return static_cast< unsigned >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i* >( p ) ), stx ) ) );
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    inline unsigned _stx_mask_avx2( const uint8_t* p )
+    {
+        const __m256i stx = _mm256_set1_epi8( static_cast< char >( SSP_STX ) );
+        return static_cast< unsigned >( _mm256_movemask_epi8( _mm256_cmpeq_epi8( _mm256_loadu_si256( reinterpret_cast< const __m256i* >( p ) ), stx ) ) );
+    }
+
+    size_t _find_sse2( const uint8_t* p, size_t n, size_t i )
+    {
+        for( ; i + 16 <= n; i += 16 ) {
+            const unsigned mask = _stx_mask_sse2( p + i );
+            if( mask != 0 ) {
+                return i + static_cast< size_t >( __builtin_ctz( mask ) );
+            }
+        }
+        for( ; i < n && p[ i ] != SSP_STX; ++i ) {
+        }
+        return i;
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    size_t _find_avx2( const uint8_t* p, size_t n )
+    {
+        size_t i{ 0 };
+        for( ; i + 32 <= n; i += 32 ) {
+            const unsigned mask = _stx_mask_avx2( p + i );
+            if( mask != 0 ) {
+                return i + static_cast< size_t >( __builtin_ctz( mask ) );
+            }
+        }
+        return _find_sse2( p, n, i );
+    }
+
+    size_t _count_sse2( const uint8_t* p, size_t n, size_t i )
+    {
+        size_t nCount{ 0 };
+        for( ; i + 16 <= n; i += 16 ) {
+            nCount += static_cast< size_t >( __builtin_popcount( _stx_mask_sse2( p + i ) ) );
+        }
+        for( ; i < n; ++i ) {
+            nCount += p[ i ] == SSP_STX;
+        }
+        return nCount;
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    size_t _count_avx2( const uint8_t* p, size_t n )
+    {
+        size_t nCount{ 0 };
+        size_t i{ 0 };
+        for( ; i + 32 <= n; i += 32 ) {
+            nCount += static_cast< size_t >( __builtin_popcount( _stx_mask_avx2( p + i ) ) );
+        }
+        return nCount + _count_sse2( p, n, i );
+    }
+
+#elif defined( __aarch64__ )
+
+    // 4 bits per byte of the comparison
+    inline uint64_t _stx_mask( const uint8_t* p )
+    {
+        const uint8x16_t eq = vceqq_u8( vld1q_u8( p ), vdupq_n_u8( SSP_STX ) );
+        return vget_lane_u64( vreinterpret_u64_u8( vshrn_n_u16( vreinterpretq_u16_u8( eq ), 4 ) ), 0 );
+    }
+
+#endif
+}
+
+size_t SSPFindStx( const uint8_t* pData, size_t nSize )
+{
+#if defined( __x86_64__ )
+    return nSize >= 32 && g_bHasAvx2 ? _find_avx2( pData, nSize ) : _find_sse2( pData, nSize, 0 );
+#elif defined( __aarch64__ )
+    size_t i{ 0 };
+    for( ; i + 16 <= nSize; i += 16 ) {
+        const uint64_t mask = _stx_mask( pData + i );
+        if( mask != 0 ) {
+            return i + static_cast< size_t >( __builtin_ctzll( mask ) >> 2 );
+        }
+    }
+    for( ; i < nSize && pData[ i ] != SSP_STX; ++i ) {
+    }
+    return i;
+#else
+    const void* pStx = std::memchr( pData, SSP_STX, nSize );
+    return pStx ? static_cast< size_t >( static_cast< const uint8_t* >( pStx ) - pData ) : nSize;
+#endif
+}
+
+size_t SSPCountStx( const uint8_t* pData, size_t nSize )
+{
+#if defined( __x86_64__ )
+    return nSize >= 32 && g_bHasAvx2 ? _count_avx2( pData, nSize ) : _count_sse2( pData, nSize, 0 );
+#else
+    size_t nCount{ 0 };
+    size_t i{ 0 };
+#if defined( __aarch64__ )
+    for( ; i + 16 <= nSize; i += 16 ) {
+        nCount += static_cast< size_t >( __builtin_popcountll( _stx_mask( pData + i ) ) ) / 4;
+    }
+#endif
+    for( ; i < nSize; ++i ) {
+        nCount += pData[ i ] == SSP_STX;
+    }
+    return nCount;
+#endif
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Scans for the SSP STX byte (0x7F), 32 bytes per compare with AVX2 (detected when the library loads),
+// 16 with SSE2 or NEON, memchr elsewhere. The frame decoder finds the frame starts and the stuffed bytes
+// with them, the encoder the bytes to stuff
+
+// Index of the first STX among the nSize bytes at pData, nSize if there is none
+size_t SSPFindStx( const uint8_t* pData, size_t nSize );
+
+// Number of STX among the nSize bytes at pData
+size_t SSPCountStx( const uint8_t* pData, size_t nSize );
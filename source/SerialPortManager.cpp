@@ -0,0 +1,139 @@
+#include "SerialPortManager.h"
+#include <algorithm>
+
+CSerialPortManager& CSerialPortManager::Instance()
+{
+    static CSerialPortManager manager;
+    return manager;
+}
+
+CSerialPortManager::CSerialPortManager() = default;
+
+CSerialPortManager::~CSerialPortManager()
+{
+    std::unique_lock< std::mutex > _lck{ m_mtx };
+    _stop_threads( _lck );
+}
+
+void CSerialPortManager::SetThreadsCount( size_t nThreads )
+{
+    std::unique_lock< std::mutex > _lck{ m_mtx };
+
+    m_nThreadsCount = std::max< size_t >( nThreads, 1 );
+
+    // Not running yet, being stopped or unable to join ourselves - the value will be applied on the next start
+    if( m_threads.empty() || _is_reactor_thread() ) {
+        return;
+    }
+
+    // Pending handlers survive io_service::stop() so the pool may be safely restarted.
+    // An idle pool (see Unregister()) is only joined
+    _stop_threads( _lck );
+    if( !m_ports.empty() ) {
+        _start_threads();
+    }
+}
+
+size_t CSerialPortManager::GetThreadsCount()
+{
+    std::lock_guard< std::mutex > _{ m_mtx };
+    return m_nThreadsCount;
+}
+
+void CSerialPortManager::Register( CThreadedSerialPort* pPort )
+{
+    std::unique_lock< std::mutex > _lck{ m_mtx };
+
+    m_ports.insert( pPort );
+    if( m_bStopping ) {
+        // The thread stopping the pool restarts it once joined as there are ports again
+        return;
+    }
+    if( m_threads.empty() ) {
+        _start_threads();
+        return;
+    }
+
+    // The pool was left winding down by Unregister() on a reactor thread. The work is added first:
+    // either the pool is still running and keeps on, or it has already run out of work and is restarted
+    if( !m_work ) {
+        m_work.reset( new boost::asio::io_service::work( m_io_service ) );
+    }
+    if( m_io_service.stopped() ) {
+        _stop_threads( _lck );
+        if( !m_ports.empty() ) {
+            _start_threads();
+        }
+    }
+}
+
+void CSerialPortManager::Unregister( CThreadedSerialPort* pPort )
+{
+    std::unique_lock< std::mutex > _lck{ m_mtx };
+
+    m_ports.erase( pPort );
+    if( !m_ports.empty() || m_threads.empty() ) {
+        return;
+    }
+
+    if( _is_reactor_thread() ) {
+        // A pool thread is unable to join itself: the threads exit as soon as the last handlers complete
+        // and are joined by the next Register(), SetThreadsCount() or the destructor
+        m_work.reset();
+    } else {
+        _stop_threads( _lck );
+        // Ports registered while the threads were joined
+        if( !m_ports.empty() ) {
+            _start_threads();
+        }
+    }
+}
+
+size_t CSerialPortManager::GetPortsCount()
+{
+    std::lock_guard< std::mutex > _{ m_mtx };
+    return m_ports.size();
+}
+
+void CSerialPortManager::_start_threads()
+{
+    // If the pool is restarted - the service is extremely important to reset
+    m_io_service.reset();
+    m_work.reset( new boost::asio::io_service::work( m_io_service ) );
+
+    for( size_t i = 0; i < m_nThreadsCount; ++i ) {
+        m_threads.emplace_back( EThreadRole::Reactor, [ this ] { _fnRunner(); }, "-" + std::to_string( i ) );
+    }
+}
+
+void CSerialPortManager::_stop_threads( std::unique_lock< std::mutex >& lck )
+{
+    m_work.reset();
+    m_io_service.stop();
+
+    // A handler still running may call back into the manager (a connection or log callback opening
+    // or closing a port), so the threads are joined without the lock
+    std::vector< CLibraryThread > threads;
+    threads.swap( m_threads );
+    m_bStopping = true;
+
+    lck.unlock();
+    for( auto& t : threads ) {
+        t.Join();
+    }
+    lck.lock();
+
+    m_bStopping = false;
+}
+
+void CSerialPortManager::_fnRunner()
+{
+    m_io_service.run();
+}
+
+bool CSerialPortManager::_is_reactor_thread()
+{
+    return std::any_of( m_threads.cbegin(), m_threads.cend(), []( const CLibraryThread& t ) {
+        return t.IsCurrent();
+    } );
+}
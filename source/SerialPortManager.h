@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+#include <set>
+#include <mutex>
+#include <memory>
+#include <boost/asio.hpp>
+#include "LibraryThread.h"
+
+class CThreadedSerialPort;
+
+// Shared reactor for all the serial ports of the process.
+// Any number of CThreadedSerialPort instances are multiplexed onto one io_service
+// which is run by a small pool of threads. The pool is started when the first port
+// is registered and stopped when the last one is unregistered. If that happens on a
+// pool thread the pool just runs out of work and its threads are joined later.
+class CSerialPortManager {
+public:
+    static CSerialPortManager& Instance();
+
+    CSerialPortManager( const CSerialPortManager& ) = delete;
+    CSerialPortManager& operator=( const CSerialPortManager& ) = delete;
+
+    // Number of threads running the shared io_service.
+    // If the pool is already running the new value is applied immediately
+    void SetThreadsCount( size_t nThreads );
+    size_t GetThreadsCount();
+
+    boost::asio::io_service& GetIoService() { return m_io_service; }
+
+    // Ports register themselves when start reading and unregister when stopped
+    void Register( CThreadedSerialPort* pPort );
+    void Unregister( CThreadedSerialPort* pPort );
+
+    size_t GetPortsCount();
+
+private:
+    CSerialPortManager();
+    ~CSerialPortManager();
+
+    void _start_threads();
+    // Stops the pool and joins its threads with the lock released
+    void _stop_threads( std::unique_lock< std::mutex >& lck );
+    void _fnRunner();
+
+    // True if called from one of the pool threads
+    bool _is_reactor_thread();
+
+private:
+    std::mutex m_mtx;
+
+    boost::asio::io_service m_io_service;
+    std::unique_ptr< boost::asio::io_service::work > m_work;
+
+    size_t m_nThreadsCount{ 1 };
+    std::vector< CLibraryThread > m_threads;
+    // The threads are being joined by _stop_threads()
+    bool m_bStopping{ false };
+
+    std::set< CThreadedSerialPort* > m_ports;
+};
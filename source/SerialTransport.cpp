@@ -0,0 +1,61 @@
+#include "SerialTransport.h"
+
+CSerialTransport::CSerialTransport( boost::asio::io_service& io_service, std::string strName )
+    : m_strName{ std::move( strName ) }
+    , m_port{ io_service }
+{
+}
+
+void CSerialTransport::Open( const std::string& strDevicePath, boost::system::error_code& ec )
+{
+    m_port.open( strDevicePath, ec );
+}
+
+void CSerialTransport::Close()
+{
+    boost::system::error_code ec;
+    m_port.close( ec );
+}
+
+void CSerialTransport::Cancel()
+{
+    boost::system::error_code ec;
+    m_port.cancel( ec );
+}
+
+void CSerialTransport::SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec )
+{
+    m_port.set_option( boost::asio::serial_port_base::baud_rate( settings.nBaud ), ec );
+    if( !ec ) {
+        m_port.set_option( boost::asio::serial_port_base::parity( settings.parity ), ec );
+    }
+    if( !ec ) {
+        m_port.set_option( boost::asio::serial_port_base::character_size( settings.nCharacterSize ), ec );
+    }
+    if( !ec ) {
+        m_port.set_option( boost::asio::serial_port_base::stop_bits( settings.stopBits ), ec );
+    }
+    if( !ec ) {
+        m_port.set_option( boost::asio::serial_port_base::flow_control( settings.flowControl ), ec );
+    }
+}
+
+void CSerialTransport::AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler )
+{
+    m_port.async_read_some( buffer, std::move( fnHandler ) );
+}
+
+void CSerialTransport::AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler )
+{
+    boost::asio::async_write( m_port, CConstBufferList{ pBuffers, nBuffers }, std::move( fnHandler ) );
+}
+
+size_t CSerialTransport::Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec )
+{
+    return boost::asio::write( m_port, CConstBufferList{ pBuffers, nBuffers }, ec );
+}
+
+int CSerialTransport::GetTtyHandle()
+{
+    return m_port.is_open() ? static_cast< int >( m_port.native_handle() ) : -1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Transport.h"
+
+// A serial device node: /dev/ttyUSB0, /dev/ttyS0, a pty slave, /dev/serial/by-id/...
+class CSerialTransport : public CTransport {
+public:
+    CSerialTransport( boost::asio::io_service& io_service, std::string strName );
+
+    std::string GetName() const override { return m_strName; }
+
+    void Open( const std::string& strDevicePath, boost::system::error_code& ec ) override;
+    bool IsOpen() const override { return m_port.is_open(); }
+    void Close() override;
+    void Cancel() override;
+
+    void SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec ) override;
+
+    void AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler ) override;
+    void AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler ) override;
+    size_t Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec ) override;
+
+    int GetTtyHandle() override;
+
+private:
+    std::string m_strName;
+    boost::asio::serial_port m_port;
+};
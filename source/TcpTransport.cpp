@@ -0,0 +1,77 @@
+#include "TcpTransport.h"
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+CTcpTransport::CTcpTransport( boost::asio::io_service& io_service, std::string strHost, std::string strPort )
+    : m_strHost{ std::move( strHost ) }
+    , m_strPort{ std::move( strPort ) }
+    , m_socket{ io_service }
+{
+}
+
+void CTcpTransport::Open( const std::string& /* strDevicePath */, boost::system::error_code& ec )
+{
+    boost::asio::ip::tcp::resolver resolver{ m_socket.get_executor() };
+    auto endpoints = resolver.resolve( m_strHost, m_strPort, ec );
+    if( ec ) {
+        return;
+    }
+
+    boost::asio::connect( m_socket, endpoints, ec );
+    if( ec ) {
+        return;
+    }
+
+    m_socket.set_option( boost::asio::ip::tcp::no_delay( true ), ec );
+    if( ec ) {
+        return;
+    }
+
+    // A dead device server or link is reported to the reader as timed_out in about
+    // KEEPALIVE_IDLE_SEC + KEEPALIVE_INTERVAL_SEC * KEEPALIVE_COUNT and the port reconnects
+    m_socket.set_option( boost::asio::socket_base::keep_alive( true ), ec );
+    if( ec ) {
+        return;
+    }
+    const int fd = static_cast< int >( m_socket.native_handle() );
+    const int nIdle{ KEEPALIVE_IDLE_SEC };
+    const int nInterval{ KEEPALIVE_INTERVAL_SEC };
+    const int nCount{ KEEPALIVE_COUNT };
+    ::setsockopt( fd, IPPROTO_TCP, TCP_KEEPIDLE, &nIdle, sizeof( nIdle ) );
+    ::setsockopt( fd, IPPROTO_TCP, TCP_KEEPINTVL, &nInterval, sizeof( nInterval ) );
+    ::setsockopt( fd, IPPROTO_TCP, TCP_KEEPCNT, &nCount, sizeof( nCount ) );
+}
+
+void CTcpTransport::Close()
+{
+    boost::system::error_code ec;
+    m_socket.shutdown( boost::asio::ip::tcp::socket::shutdown_both, ec );
+    m_socket.close( ec );
+}
+
+void CTcpTransport::Cancel()
+{
+    boost::system::error_code ec;
+    m_socket.cancel( ec );
+}
+
+void CTcpTransport::SetLineSettings( const SLineSettings& /* settings */, boost::system::error_code& ec )
+{
+    // Raw mode: the line of the device server is configured on the server itself
+    ec.clear();
+}
+
+void CTcpTransport::AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler )
+{
+    m_socket.async_read_some( buffer, std::move( fnHandler ) );
+}
+
+void CTcpTransport::AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler )
+{
+    boost::asio::async_write( m_socket, CConstBufferList{ pBuffers, nBuffers }, std::move( fnHandler ) );
+}
+
+size_t CTcpTransport::Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec )
+{
+    return boost::asio::write( m_socket, CConstBufferList{ pBuffers, nBuffers }, ec );
+}
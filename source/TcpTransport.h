@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Transport.h"
+
+// Raw TCP byte stream to a serial device server ("tcp://host:port").
+// TCP_NODELAY is set: SSP packets are small and each one waits for its reply.
+// TCP keepalive detects a silently dropped connection
+class CTcpTransport : public CTransport {
+public:
+    CTcpTransport( boost::asio::io_service& io_service, std::string strHost, std::string strPort );
+
+    std::string GetName() const override { return "tcp://" + m_strHost + ":" + m_strPort; }
+
+    void Open( const std::string& strDevicePath, boost::system::error_code& ec ) override;
+    bool IsOpen() const override { return m_socket.is_open(); }
+    void Close() override;
+    void Cancel() override;
+
+    void SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec ) override;
+
+    void AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler ) override;
+    void AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler ) override;
+    size_t Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec ) override;
+
+protected:
+    static constexpr int KEEPALIVE_IDLE_SEC = 10;
+    static constexpr int KEEPALIVE_INTERVAL_SEC = 5;
+    static constexpr int KEEPALIVE_COUNT = 3;
+
+    std::string m_strHost;
+    std::string m_strPort;
+    boost::asio::ip::tcp::socket m_socket;
+};
@@ -1,29 +1,153 @@
 #include "ThreadedSerialPort.h"
+#include "SerialPortManager.h"
+#include "HotplugMonitor.h"
+#include <cerrno>
 #include <cstdio>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <linux/serial.h>
+#include <boost/assert.hpp>
 #include <boost/bind.hpp>
 #include <utility>
 #include "strings.hpp"
 
+namespace {
+    // Input purge on open: after the flush the line has to stay quiet for this many characters, or the
+    // USB-serial latency timer if longer. Flushed again while it does not, for PURGE_LIMIT at most
+    const uint32_t PURGE_QUIET_CHARACTERS = 3;
+    const auto PURGE_MIN_QUIET = std::chrono::milliseconds( 1 );
+    const auto PURGE_LIMIT = std::chrono::milliseconds( 50 );
+
+    // The echo of a write is given up if it has not come this long after the recorded bytes were due
+    // on the line: USB-serial latency timer, converter turnaround and scheduling
+    const auto ECHO_LATENCY = std::chrono::milliseconds( 50 );
+
+    // "/dev/serial/by-id/usb-FTDI_..." -> "ttyUSB0"
+    std::string _tty_kernel_name( const std::string& strPortName )
+    {
+        char szResolved[ PATH_MAX ];
+        std::string strPath = ::realpath( strPortName.c_str(), szResolved ) ? szResolved : strPortName;
+        auto nSlash = strPath.rfind( '/' );
+        return nSlash == std::string::npos ? strPath : strPath.substr( nSlash + 1 );
+    }
+
+    std::string _real_path( const std::string& strPath )
+    {
+        char szResolved[ PATH_MAX ];
+        return ::realpath( strPath.c_str(), szResolved ) ? std::string{ szResolved } : std::string{};
+    }
+
+    // The /dev/serial/by-id alias of the device node, empty if there is none
+    std::string _find_stable_path( const std::string& strPortName )
+    {
+        static const std::string strByIdDir{ "/dev/serial/by-id/" };
+        if( 0 == strPortName.compare( 0, strByIdDir.size(), strByIdDir ) ) {
+            return strPortName;
+        }
+
+        const std::string strTarget = _real_path( strPortName );
+        std::string strResult;
+        DIR* pDir = ::opendir( strByIdDir.c_str() );
+        if( strTarget.empty() || !pDir ) {
+            if( pDir ) {
+                ::closedir( pDir );
+            }
+            return strResult;
+        }
+        while( dirent* pEntry = ::readdir( pDir ) ) {
+            if( pEntry->d_name[ 0 ] == '.' ) {
+                continue;
+            }
+            std::string strLink = strByIdDir + pEntry->d_name;
+            if( _real_path( strLink ) == strTarget ) {
+                strResult = strLink;
+                break;
+            }
+        }
+        ::closedir( pDir );
+        return strResult;
+    }
+
+    std::string _usb_serial_sysfs_dir( const std::string& strPortName )
+    {
+        return "/sys/bus/usb-serial/devices/" + _tty_kernel_name( strPortName );
+    }
+
+    int _read_sysfs_int( const std::string& strPath )
+    {
+        std::ifstream f( strPath );
+        int nValue{ -1 };
+        if( !( f >> nValue ) ) {
+            return -1;
+        }
+        return nValue;
+    }
+
+    bool _write_sysfs_int( const std::string& strPath, int nValue )
+    {
+        std::ofstream f( strPath );
+        if( !f ) {
+            return false;
+        }
+        f << nValue;
+        f.flush();
+        return static_cast< bool >( f );
+    }
+}
+
 CThreadedSerialPort::CThreadedSerialPort(std::string  strPortName, uint32_t baud, boost::asio::serial_port_base::parity::type parity, uint32_t nCharacterSize,
                                          boost::asio::serial_port_base::stop_bits::type stopBits )
     : m_bStopThread{ false }
-    , m_port{ m_io_service }
-    , m_timer{ m_io_service }
+    , m_transport{ CTransport::Create( CSerialPortManager::Instance().GetIoService(), strPortName ) }
+    , m_timer{ CSerialPortManager::Instance().GetIoService() }
+    , m_strand{ CSerialPortManager::Instance().GetIoService() }
 	, m_strPortName{std::move( strPortName )}
     , m_nBaud{ baud }
     , m_nCharacterSize{ nCharacterSize }
     , m_Parity{ parity }
     , m_StopBits{ stopBits }
     , m_FlowControl{ boost::asio::serial_port_base::flow_control::none }
+    , m_read_buffer( READ_BUFFER_SIZE )
+    , m_rx_ring{ RX_RING_CAPACITY }
+    , m_echo_ring{ ECHO_RING_CAPACITY }
+    , m_fnOnFrame{ [ this ]( const SSspFrame& frame ) { _on_frame( frame ); } }
 {	
 }
 
+CThreadedSerialPort::CThreadedSerialPort( std::unique_ptr< CTransport > pTransport, uint32_t baud, boost::asio::serial_port_base::parity::type parity, uint32_t nCharacterSize,
+                                          boost::asio::serial_port_base::stop_bits::type stopBits )
+    : m_bStopThread{ false }
+    , m_transport{ std::move( pTransport ) }
+    , m_timer{ CSerialPortManager::Instance().GetIoService() }
+    , m_strand{ CSerialPortManager::Instance().GetIoService() }
+    , m_strPortName{ m_transport->GetName() }
+    , m_nBaud{ baud }
+    , m_nCharacterSize{ nCharacterSize }
+    , m_Parity{ parity }
+    , m_StopBits{ stopBits }
+    , m_FlowControl{ boost::asio::serial_port_base::flow_control::none }
+    , m_read_buffer( READ_BUFFER_SIZE )
+    , m_rx_ring{ RX_RING_CAPACITY }
+    , m_echo_ring{ ECHO_RING_CAPACITY }
+    , m_fnOnFrame{ [ this ]( const SSspFrame& frame ) { _on_frame( frame ); } }
+{
+}
+
 CThreadedSerialPort::~CThreadedSerialPort()
 {
     if( m_fnLog ) {
         m_fnLog( false, 0, L"~CSerialPort2() >" );
     }
 
+    // Destroyed on a reactor thread the port would be gone before its handlers drain
+    BOOST_ASSERT_MSG( !m_bRegistered || !CLibraryThread::IsCurrentRole( EThreadRole::Reactor ),
+                      "a started port must not be destroyed on a reactor thread" );
     StopThread();
 
     if( m_fnLog ) {
@@ -41,10 +165,13 @@ bool CThreadedSerialPort::Open(bool bPurgeRxBuffer )
 
 bool CThreadedSerialPort::ChangeSettings(uint32_t baud, uint32_t nCharacterSize, boost::asio::serial_port_base::parity::type parity )
 {
-    if( m_port.is_open() ){
-        m_port.set_option( boost::asio::serial_port::baud_rate( baud ) );
-        m_port.set_option( boost::asio::serial_port_base::parity( parity ) );
-        m_port.set_option( boost::asio::serial_port_base::character_size( nCharacterSize ) );
+    if( m_transport->IsOpen() ){
+        m_nBaud = baud;
+        m_nCharacterSize = nCharacterSize;
+        m_Parity = parity;
+        if( !_apply_line_settings() ) {
+            return false;
+        }
 
         std::wstringstream msg;
         msg << L"Port '" << utf8_to_wstring( m_strPortName ) << L"' opened" << std::endl;
@@ -70,9 +197,12 @@ bool CThreadedSerialPort::ChangeSettings(uint32_t baud, uint32_t nCharacterSize,
 
 bool CThreadedSerialPort::SetBaudrate(uint32_t baud )
 {
-    if( m_port.is_open() ) {
+    if( m_transport->IsOpen() ) {
 
-        m_port.set_option( boost::asio::serial_port::baud_rate( baud ) );
+        m_nBaud = baud;
+        if( !_apply_line_settings() ) {
+            return false;
+        }
 
         if( m_fnLog ) {
             std::wstringstream msg;
@@ -90,18 +220,26 @@ bool CThreadedSerialPort::SetBaudrate(uint32_t baud )
 
 void CThreadedSerialPort::StartThread(bool bPurgeRxBuffer )
 {
-    if( m_thread.joinable() ) {
+    if( m_bRegistered ) {
         StopThread();
     }
 
     // Ensure the port is open
-    if( !m_port.is_open() ) {
+    if( !m_transport->IsOpen() ) {
         _open( bPurgeRxBuffer );
     }
 
-	m_thread = std::thread{
-            &CThreadedSerialPort::_fnReadingThread, this
-	};
+    if( m_fnLog ) {
+        m_fnLog( false, 0, L"CSerialPort2::StartThread() - registering within the shared reactor" );
+    }
+
+    // The reader thread is the only producer from now on
+    _clear_rx();
+
+    m_bRegistered = true;
+    CSerialPortManager::Instance().Register( this );
+
+    _post( [ this ] { _start_port_async_reading(); } );
 }
 
 void CThreadedSerialPort::StopThread()
@@ -111,49 +249,114 @@ void CThreadedSerialPort::StopThread()
     }
 
     {
-        std::lock_guard< boost::mutex > _( m_wait_for_incoming_data_mtx );
+        // Under the write lock so no write request is queued behind the stop (see AsyncWrite())
+        std::lock_guard< std::mutex > _lck( m_write_mtx );
+        m_bStopThread = true;
+    }
 
-        m_timer.cancel();
+    if( m_bRegistered ) {
 
-        m_bStopThread = true;
+        // No hot-plug notifications from now on
+        CHotplugMonitor::Instance().Unsubscribe( this );
 
-        _close();
+        // On a reactor thread (a handler or a connection callback) waiting for the handlers of the port may need
+        // this very thread: the last of them completes the stop instead
+        if( CLibraryThread::IsCurrentRole( EThreadRole::Reactor ) ) {
+            {
+                // Counted as pending itself so no handler completes the stop before the close is queued
+                std::lock_guard< std::mutex > _lck( m_pending_mtx );
+                m_bStopDeferred = true;
+                ++m_nPendingOperations;
+            }
+            CPendingOperation _op{ *this };
+            _post( [ this ] {
+                m_timer.cancel();
+                _close();
+            } );
+
+            if( m_fnLog ) {
+                m_fnLog( false, 0, L"CSerialPort2::StopThread() < deferred to the last pending handler" );
+            }
+            return;
+        }
 
-        m_wait_for_incoming_data.notify_all();
-    }
+        // The port is shared with the reactor threads - close it from within the port's strand.
+        // The queued writes are failed by handle_write() / _start_write() as soon as they see m_bStopThread
+        _post( [ this ] {
+            m_timer.cancel();
+            _close();
+        } );
 
-    if( m_thread.joinable() ) {
+        // Wait until all the handlers of the port are completed
+        {
+            std::unique_lock< std::mutex > _lck( m_pending_mtx );
+            m_pending_cv.wait( _lck, [ this ] { return 0 == m_nPendingOperations; } );
+            m_bStopDeferred = false;
+        }
 
-        // Additional action to force exiting of reading thread
-        m_io_service.stop();
+        _complete_stop();
+    } else {
+        m_timer.cancel();
+        _close();
 
-        m_thread.join();
+        {
+            std::lock_guard< std::mutex > _( m_wait_for_incoming_data_mtx );
+            m_wait_for_incoming_data.notify_all();
+        }
+        m_bStopThread = false;
     }
-    m_bStopThread = false;
 
     if( m_fnLog ) {
         m_fnLog( false, 0, L"CSerialPort2::StopThread() <" );
     }
 }
 
+void CThreadedSerialPort::_complete_stop()
+{
+    CSerialPortManager::Instance().Unregister( this );
+    m_bRegistered = false;
+
+    {
+        std::lock_guard< std::mutex > _( m_wait_for_incoming_data_mtx );
+        m_wait_for_incoming_data.notify_all();
+    }
+
+    m_bStopThread = false;
+}
+
 bool CThreadedSerialPort::_open(bool bPurgeRxBuffer )
 {
-    try {
-        m_port.open( m_strPortName );
+    // Once the stable alias is known never fall back to the plain node: it may belong to another adapter by now
+    std::string strDevicePath;
+    {
+        std::lock_guard< std::mutex > _lck( m_path_mtx );
+        strDevicePath = m_strStablePath.empty() ? m_strPortName : m_strStablePath;
     }
-    catch( ... ) {
+
+    boost::system::error_code ec;
+    m_transport->Open( strDevicePath, ec );
+    if( ec ) {
         if( m_fnLog ) {
-            m_fnLog( true, 0, L"Open port failed" );
+            m_fnLog( true, 0, L"Open port failed: " + utf8_to_wstring( ec.message() ) );
         }
         return false;
     }
 
-    if( m_port.is_open() ) {
-        m_port.set_option( boost::asio::serial_port::baud_rate( m_nBaud ) );
-        m_port.set_option( boost::asio::serial_port_base::parity( m_Parity ) );
-        m_port.set_option( boost::asio::serial_port_base::character_size(m_nCharacterSize) );
-        m_port.set_option( boost::asio::serial_port_base::stop_bits(m_StopBits) );
-        m_port.set_option( boost::asio::serial_port_base::flow_control(m_FlowControl) );
+    {
+        std::string strStablePath = _find_stable_path( strDevicePath );
+        std::lock_guard< std::mutex > _lck( m_path_mtx );
+        m_strDevicePath = strDevicePath;
+        if( !strStablePath.empty() ) {
+            m_strStablePath = strStablePath;
+        }
+    }
+
+    if( m_transport->IsOpen() ) {
+        _apply_line_settings();
+
+        if( m_bLowLatencyRequested && m_transport->GetTtyHandle() >= 0 ) {
+            _apply_low_latency_profile();
+        }
 
         std::wstringstream msg; { };
         msg << L"Port '" << utf8_to_wstring( m_strPortName )<< L"' opened" << std::endl;
@@ -169,16 +372,70 @@ bool CThreadedSerialPort::_open(bool bPurgeRxBuffer )
         }
 
         if( bPurgeRxBuffer ) {
+            _purge_rx_buffer();
+        }
+    }
 
-            for( ; ; ) {
-                std::pair< bool, std::vector< uint8_t > > r = WaitForIncomingData( 1, 10, false );
-                if(!r.first) {
-                    break;
-                }
-            }
+    return true;
+}
+
+void CThreadedSerialPort::_purge_rx_buffer()
+{
+    // Only a tty buffers input in the kernel; the other transports deliver nothing before the reader starts
+    const int fd = m_transport->GetTtyHandle();
+    if( fd < 0 ) {
+        return;
+    }
+
+    std::chrono::nanoseconds tQuiet = std::max< std::chrono::nanoseconds >( PURGE_MIN_QUIET, _character_time() * PURGE_QUIET_CHARACTERS );
+    const int nLatencyTimer = _read_sysfs_int( _usb_serial_sysfs_dir( GetDevicePath() ) + "/latency_timer" );
+    if( nLatencyTimer > 0 ) {
+        tQuiet = std::max< std::chrono::nanoseconds >( tQuiet, std::chrono::milliseconds( nLatencyTimer ) );
+    }
+
+    const auto tDeadline = std::chrono::steady_clock::now() + PURGE_LIMIT;
+    size_t nFlushes{ 0 };
+    for( ; ; ) {
+        ::tcflush( fd, TCIFLUSH );
+        ++nFlushes;
+
+        const auto tNow = std::chrono::steady_clock::now();
+        if( tNow >= tDeadline ) {
+            break;
+        }
+        const auto tWait = std::min< std::chrono::nanoseconds >( tQuiet, tDeadline - tNow );
+        timespec timeout{ static_cast< time_t >( tWait.count() / 1000000000 ), static_cast< long >( tWait.count() % 1000000000 ) };
+        pollfd pfd{ fd, POLLIN, 0 };
+        int nResult = ::ppoll( &pfd, 1, &timeout, nullptr );
+        if( nResult == 0 || ( nResult < 0 && errno != EINTR ) || ( pfd.revents & ( POLLERR | POLLHUP | POLLNVAL ) ) ) {
+            break;
         }
     }
 
+    if( nFlushes > 1 && m_fnLog ) {
+        std::wostringstream logStream;
+        logStream << L"Input purged " << nFlushes << L" times before the line went quiet";
+        m_fnLog( false, 150, logStream.str() );
+    }
+}
+
+bool CThreadedSerialPort::_apply_line_settings()
+{
+    CTransport::SLineSettings settings;
+    settings.nBaud = m_nBaud;
+    settings.nCharacterSize = m_nCharacterSize;
+    settings.parity = m_Parity;
+    settings.stopBits = m_StopBits;
+    settings.flowControl = m_FlowControl;
+
+    boost::system::error_code ec;
+    m_transport->SetLineSettings( settings, ec );
+    if( ec ) {
+        if( m_fnLog ) {
+            m_fnLog( true, 0, L"Port settings failed: " + utf8_to_wstring( ec.message() ) );
+        }
+        return false;
+    }
     return true;
 }
 
@@ -188,22 +445,22 @@ void CThreadedSerialPort::_close()
         m_fnLog( false, 0, L"CSerialPort2::_close() >" );
     }
 
-    if( m_port.is_open() ) {
-		m_port.cancel();
+    if( m_transport->IsOpen() ) {
+		m_transport->Cancel();
+
+        _restore_latency_timer();
 
-        int fd{ -1 };
         if( m_bNV200WierdDeinitializationRequired ) {
             // TODO: will this help?
-            fd = static_cast< int >( m_port.native_handle() );
-            ::tcflush( fd, TCIOFLUSH );
+            const int fd = m_transport->GetTtyHandle();
+            if( fd >= 0 ) {
+                ::tcflush( fd, TCIOFLUSH );
+            }
         }
 
-        m_port.close();
-
-        if( m_bNV200WierdDeinitializationRequired ) {
-            // TODO: asking for a close one more time
-            ::close( fd );
-        }
+        // Every transport with a tty handle closes it itself. Closing the number once more
+        // would hit whatever descriptor another thread got meanwhile
+        m_transport->Close();
     }
 
     if( m_fnLog ) {
@@ -212,29 +469,121 @@ void CThreadedSerialPort::_close()
 }
 
 bool CThreadedSerialPort::Write(const std::vector< uint8_t>& pData, bool bClearAccumulator)
+{
+    return Write( pData.data(), pData.size(), bClearAccumulator );
+}
+
+bool CThreadedSerialPort::Write( const uint8_t* pData, size_t nSize, bool bClearAccumulator )
+{
+    boost::asio::const_buffer buffer{ pData, nSize };
+    return Write( &buffer, 1, bClearAccumulator );
+}
+
+bool CThreadedSerialPort::Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, bool bClearAccumulator )
+{
+    return _write( pBuffers, nBuffers, bClearAccumulator, nullptr );
+}
+
+bool CThreadedSerialPort::Write( const uint8_t* pData, size_t nSize, SWriteCompletion& completion, bool bClearAccumulator, bool bWaitForDrain )
+{
+    boost::asio::const_buffer buffer{ pData, nSize };
+    return _write( &buffer, 1, bClearAccumulator, &completion, bWaitForDrain );
+}
+
+bool CThreadedSerialPort::_write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, bool bClearAccumulator, SWriteCompletion* pCompletion, bool bWaitForDrain )
 {
     if( bClearAccumulator ) {
-        std::lock_guard< std::mutex > _lck( m_accum_mtx );
-        m_accumulator.clear();
+        _clear_rx();
     }
 
 	if( m_fnLog ) {
         std::wostringstream logStream;
-        logStream << L"> [SERIAL] write " << pData.size() << L" bytes: " << std::endl << dump_bin_as_string( pData, 1 ) << std::endl;
+        for( size_t i = 0; i < nBuffers; ++i ) {
+            logStream << L"> [SERIAL] write " << pBuffers[ i ].size() << L" bytes: " << std::endl
+                      << dump_bin_as_string( static_cast< const uint8_t* >( pBuffers[ i ].data() ), pBuffers[ i ].size(), 1 ) << std::endl;
+        }
         m_fnLog( false, 150, logStream.str() );
 	}
-	try {
-        // @note The write_some operation may not transmit all of the data to the
-        // peer. Consider using the @ref write function if you need to ensure that
-        // all data is written before the blocking operation completes.
-        auto nBytesWritten = m_port.write_some( boost::asio::buffer( pData.data(), pData.size() ) );
-        for( ; nBytesWritten < pData.size(); ) {
-            nBytesWritten += m_port.write_some( boost::asio::buffer( pData.data() + nBytesWritten, pData.size() - nBytesWritten ) );
+
+    boost::system::error_code ec;
+
+    std::unique_lock< std::mutex > _lck( m_write_mtx );
+    if( !m_bRegistered ) {
+
+        // No reactor to run the queue. Serialize the writers with the lock
+        _record_echo( pBuffers, nBuffers );
+        m_transport->Write( pBuffers, nBuffers, ec );
+
+    } else if( m_bStopThread ) {
+
+        ec = boost::asio::error::operation_aborted;
+
+    } else if( !m_bWriteInProgress ) {
+
+        // Nothing queued - write directly from the caller's thread.
+        // Gathers the caller's buffers into as few writev() calls as possible, no copies
+        m_bWriteInProgress = true;
+        {
+            // Pending until the queue is handed over below, so StopThread() does not complete meanwhile
+            std::lock_guard< std::mutex > _pending_lck( m_pending_mtx );
+            ++m_nPendingOperations;
         }
-	}
-    catch( std::exception& ex ) {
+        CPendingOperation _op{ *this };
+        _lck.unlock();
+
+        _record_echo( pBuffers, nBuffers );
+        m_transport->Write( pBuffers, nBuffers, ec );
+
+        _lck.lock();
+        if( m_write_queue.empty() ) {
+            m_bWriteInProgress = false;
+        } else {
+            // AsyncWrite() requests arrived meanwhile
+            _post( [ this ] { _start_write(); } );
+        }
+    } else if( nBuffers > 0 ) {
+
+        // Keep the order: queue behind the pending requests. The caller's memory stays valid as we wait.
+        // A batch may split the gather list, so every buffer completes the request and the first error is kept.
+        // The handlers run within the strand one after another
+        std::promise< boost::system::error_code > promise;
+        auto result = promise.get_future();
+        size_t nPending{ nBuffers };
+        boost::system::error_code firstError;
+        for( size_t i = 0; i < nBuffers; ++i ) {
+            SWriteRequest request;
+            request.buffer = pBuffers[ i ];
+            request.fnHandler = [ &promise, &nPending, &firstError ]( const SWriteCompletion& completion ) {
+                if( completion.ec && !firstError ) {
+                    firstError = completion.ec;
+                }
+                if( 0 == --nPending ) {
+                    promise.set_value( firstError );
+                }
+            };
+            m_write_queue.push_back( std::move( request ) );
+        }
+        _lck.unlock();
+
+        ec = result.get();
+    }
+
+    if( pCompletion ) {
+        pCompletion->ec = ec;
+        pCompletion->nBytes = 0;
+        for( size_t i = 0; !ec && i < nBuffers; ++i ) {
+            pCompletion->nBytes += pBuffers[ i ].size();
+        }
+        if( ec ) {
+            pCompletion->tDrained = std::chrono::steady_clock::now();
+        } else {
+            pCompletion->tDrained = bWaitForDrain ? _wait_tx_drained() : _tx_drained_time();
+        }
+    }
+
+    if( ec ) {
 		if( m_fnLog ) {
-            m_fnLog( true, 0, L"Write port failed: " + utf8_to_wstring( ex.what() ) );
+            m_fnLog( true, 0, L"Write port failed: " + utf8_to_wstring( ec.message() ) );
 		}
 		return false;
 	}
@@ -242,61 +591,320 @@ bool CThreadedSerialPort::Write(const std::vector< uint8_t>& pData, bool bClearA
 	return true;
 }
 
-void CThreadedSerialPort::_start_port_async_reading()
+void CThreadedSerialPort::AsyncWrite( const uint8_t* pData, size_t nSize, write_handler_t fnHandler )
+{
+    if( !m_bRegistered || m_bStopThread ) {
+        if( fnHandler ) {
+            SWriteCompletion completion;
+            completion.ec = boost::asio::error::bad_descriptor;
+            completion.tDrained = std::chrono::steady_clock::now();
+            fnHandler( completion );
+        }
+        return;
+    }
+
+    SWriteRequest request;
+    request.vData.assign( pData, pData + nSize );
+    request.buffer = boost::asio::buffer( request.vData );
+    request.fnHandler = std::move( fnHandler );
+
+    {
+        std::lock_guard< std::mutex > _lck( m_write_mtx );
+        // StopThread() raises the flag under this lock: the request is either queued before the stop and failed by it,
+        // or failed here. The flag is read first as _complete_stop() clears it after m_bRegistered
+        if( !m_bStopThread && m_bRegistered ) {
+            m_write_queue.push_back( std::move( request ) );
+            if( !m_bWriteInProgress ) {
+                m_bWriteInProgress = true;
+                _post( [ this ] { _start_write(); } );
+            }
+            return;
+        }
+    }
+
+    if( request.fnHandler ) {
+        SWriteCompletion completion;
+        completion.ec = boost::asio::error::bad_descriptor;
+        completion.tDrained = std::chrono::steady_clock::now();
+        request.fnHandler( completion );
+    }
+}
+
+std::future< CThreadedSerialPort::SWriteCompletion > CThreadedSerialPort::AsyncWrite( const uint8_t* pData, size_t nSize )
+{
+    auto promise = std::make_shared< std::promise< SWriteCompletion > >();
+    auto result = promise->get_future();
+    AsyncWrite( pData, nSize, [ promise ]( const SWriteCompletion& completion ) { promise->set_value( completion ); } );
+    return result;
+}
+
+void CThreadedSerialPort::_start_write()
 {
-    m_accumulator.clear();
-    m_read_buffer.resize( 1 );
-    m_port.async_read_some( boost::asio::buffer( m_read_buffer.data(), 1 ),
-                            boost::bind(
-                                    &CThreadedSerialPort::handle_read, this,
-                                    boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred
-                            )
+    if( m_bStopThread ) {
+        _fail_write_queue( boost::asio::error::operation_aborted );
+        return;
+    }
+
+    // Coalesce the adjacent queued requests into one gather write
+    m_write_buffers.clear();
+    size_t nBytes{ 0 };
+    {
+        std::lock_guard< std::mutex > _lck( m_write_mtx );
+        for( const auto& request : m_write_queue ) {
+            if(    !m_write_buffers.empty()
+                && ( m_write_buffers.size() == WRITE_BATCH_MAX_BUFFERS || nBytes + request.buffer.size() > WRITE_BATCH_MAX_BYTES ) ) {
+                break;
+            }
+            m_write_buffers.push_back( request.buffer );
+            nBytes += request.buffer.size();
+        }
+        m_nWriteBatch = m_write_buffers.size();
+
+        if( 0 == m_nWriteBatch ) {
+            m_bWriteInProgress = false;
+            return;
+        }
+    }
+
+    _record_echo( m_write_buffers.data(), m_write_buffers.size() );
+    {
+        std::lock_guard< std::mutex > _lck( m_pending_mtx );
+        ++m_nPendingOperations;
+    }
+    m_transport->AsyncWrite( m_write_buffers.data(), m_write_buffers.size(),
+                             m_strand.wrap( boost::bind(
+                                     &CThreadedSerialPort::handle_write, this,
+                                     boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred
+                             ) )
     );
 }
 
-void CThreadedSerialPort::_fnReadingThread()
+void CThreadedSerialPort::handle_write( const boost::system::error_code& error, size_t /* bytes_transferred */ )
 {
-    if( m_fnLog ) {
-        m_fnLog( false, 0, L"CSerialPort2::_fnReadingThread() >" );
+    CPendingOperation _op{ *this };
+
+    SWriteCompletion completion;
+    completion.ec = error;
+    completion.tDrained = error ? std::chrono::steady_clock::now() : _tx_drained_time();
+
+    if( error && m_fnLog ) {
+        m_fnLog( true, 0, L"Write port failed: " + utf8_to_wstring( error.message() ) );
     }
 
-	// If the thread is restarted - the service is extremely important to reset
-	m_io_service.reset();
+    m_write_completed.clear();
+    {
+        std::lock_guard< std::mutex > _lck( m_write_mtx );
+        for( size_t i = 0; i < m_nWriteBatch; ++i ) {
+            m_write_completed.push_back( std::move( m_write_queue.front() ) );
+            m_write_queue.pop_front();
+        }
+        m_nWriteBatch = 0;
+    }
 
-    _start_port_async_reading();
+    for( const auto& request : m_write_completed ) {
+        if( request.fnHandler ) {
+            completion.nBytes = error ? 0 : request.buffer.size();
+            request.fnHandler( completion );
+        }
+    }
+    m_write_completed.clear();
 
-	m_io_service.run();
+    if( m_bStopThread ) {
+        _fail_write_queue( boost::asio::error::operation_aborted );
+        return;
+    }
 
-    if( m_fnLog ) {
-        m_fnLog( false, 0, L"CSerialPort2::_fnReadingThread() <" );
+    _start_write();
+}
+
+void CThreadedSerialPort::_fail_write_queue( const boost::system::error_code& error )
+{
+    m_write_completed.clear();
+    {
+        std::lock_guard< std::mutex > _lck( m_write_mtx );
+        std::move( m_write_queue.begin(), m_write_queue.end(), std::back_inserter( m_write_completed ) );
+        m_write_queue.clear();
+        m_bWriteInProgress = false;
+    }
+
+    SWriteCompletion completion;
+    completion.ec = error;
+    completion.tDrained = std::chrono::steady_clock::now();
+    for( const auto& request : m_write_completed ) {
+        if( request.fnHandler ) {
+            request.fnHandler( completion );
+        }
+    }
+    m_write_completed.clear();
+}
+
+std::chrono::steady_clock::time_point CThreadedSerialPort::_tx_drained_time()
+{
+    auto tNow = std::chrono::steady_clock::now();
+
+    int nOutQueue{ 0 };
+    const int fd = m_transport->GetTtyHandle();
+    if( fd < 0 || ::ioctl( fd, TIOCOUTQ, &nOutQueue ) != 0 || nOutQueue <= 0 ) {
+        return tNow;
+    }
+
+    // The rest is still in the kernel output queue
+    return tNow + _character_time() * nOutQueue;
+}
+
+std::chrono::steady_clock::time_point CThreadedSerialPort::_wait_tx_drained()
+{
+    // Without flow control the UART always drains, so tcdrain() is bounded by the wire time.
+    // Otherwise the peer may hold the line - estimate from the queue instead of blocking
+    const int fd = m_transport->GetTtyHandle();
+    if( fd < 0 || m_FlowControl != boost::asio::serial_port_base::flow_control::none ) {
+        return _tx_drained_time();
+    }
+
+    int nResult;
+    do {
+        nResult = ::tcdrain( fd );
+    } while( nResult != 0 && errno == EINTR );
+
+    return nResult == 0 ? std::chrono::steady_clock::now() : _tx_drained_time();
+}
+
+std::chrono::nanoseconds CThreadedSerialPort::_character_time() const
+{
+    // Start bit, data bits, parity and stop bits per character
+    const uint32_t nBitsPerChar = 1 + m_nCharacterSize
+                                + ( m_Parity == boost::asio::serial_port_base::parity::none ? 0 : 1 )
+                                + ( m_StopBits == boost::asio::serial_port_base::stop_bits::two ? 2 : 1 );
+    return std::chrono::nanoseconds( static_cast< uint64_t >( nBitsPerChar ) * 1000000000 / std::max< uint32_t >( m_nBaud, 1 ) );
+}
+
+CThreadedSerialPort::CPendingOperation::~CPendingOperation()
+{
+    std::lock_guard< std::mutex > _lck( m_port.m_pending_mtx );
+    if( 0 == --m_port.m_nPendingOperations ) {
+        // StopThread() was called from a reactor thread and this was the last handler of the port.
+        // Completed under the lock so a blocking StopThread() (the destructor) wakes up only afterwards
+        if( std::exchange( m_port.m_bStopDeferred, false ) ) {
+            m_port._complete_stop();
+        }
+        m_port.m_pending_cv.notify_all();
+    }
+}
+
+void CThreadedSerialPort::_start_port_async_reading()
+{
+    _async_read_some();
+}
+
+void CThreadedSerialPort::_async_read_some()
+{
+    {
+        std::lock_guard< std::mutex > _lck( m_pending_mtx );
+        ++m_nPendingOperations;
     }
+
+    // Always take whatever the kernel has. Waiters are completed by the accumulated bytes count.
+    // The completion is stamped before it queues for the strand, the strand delay is host overhead.
+    // A transport with its own reactor delivers the data on that thread, one read at a time: the data path
+    // of handle_read() touches the reader state only, so it runs there. Errors go through the strand
+    const bool bOwnReactor = m_transport->HasOwnReactor();
+    m_transport->AsyncReadSome( boost::asio::buffer( m_read_buffer.data(), m_read_buffer.size() ),
+                                [ this, bOwnReactor ]( const boost::system::error_code& error, size_t bytes_transferred ) {
+                                    auto tCompleted = std::chrono::steady_clock::now();
+                                    if( bOwnReactor && !error && bytes_transferred > 0 ) {
+                                        handle_read( error, bytes_transferred, tCompleted );
+                                        return;
+                                    }
+                                    m_strand.dispatch( [ this, error, bytes_transferred, tCompleted ] {
+                                        handle_read( error, bytes_transferred, tCompleted );
+                                    } );
+                                }
+    );
+}
+
+void CThreadedSerialPort::_async_wait_reconnect()
+{
+    {
+        std::lock_guard< std::mutex > _lck( m_pending_mtx );
+        ++m_nPendingOperations;
+    }
+
+    // Exponential backoff. _on_hotplug() cancels the wait as soon as a new device shows up
+    m_timer.expires_from_now( boost::posix_time::milliseconds( m_nReconnectDelayMs ) );
+    m_nReconnectDelayMs = std::min( m_nReconnectDelayMs * 2, RECONNECT_DELAY_MAX_MS );
+    m_timer.async_wait( m_strand.wrap( boost::bind( &CThreadedSerialPort::timer_handler, this ) ) );
 }
 
 void CThreadedSerialPort::timer_handler()
 {
+    CPendingOperation _op{ *this };
+
     if( m_bStopThread ) {
         return;
     }
-	if( m_port.is_open() ) {
-		m_port.cancel();
-		m_port.close();
+	if( m_transport->IsOpen() ) {
+		m_transport->Cancel();
+		m_transport->Close();
 	}
     if( !_open( false ) ) {
-		m_timer.expires_from_now( boost::posix_time::seconds( 1 ) );
-		m_timer.async_wait( boost::bind(&CThreadedSerialPort::timer_handler, this ) );
+        _async_wait_reconnect();
 	} else {
 
+        m_bReconnecting = false;
+        CHotplugMonitor::Instance().Unsubscribe( this );
+
+        if( m_fnConnection ) {
+            m_fnConnection( true, GetDevicePath() );
+        }
+
         // The thread is already initialized. Go back to reading
         _start_port_async_reading();
 	}
 }
 
-void CThreadedSerialPort::handle_read(const boost::system::error_code& error, size_t bytes_transferred )
+void CThreadedSerialPort::_on_hotplug()
+{
+    // Called by CHotplugMonitor from a reactor thread
+    _post( [ this ] {
+        if( m_bStopThread || !m_bReconnecting ) {
+            return;
+        }
+        m_nReconnectDelayMs = RECONNECT_DELAY_MIN_MS;
+        // Makes timer_handler() retry at once
+        m_timer.cancel();
+    } );
+}
+
+std::string CThreadedSerialPort::GetDevicePath()
+{
+    std::lock_guard< std::mutex > _lck( m_path_mtx );
+    return m_strDevicePath;
+}
+
+std::string CThreadedSerialPort::GetStablePortName()
+{
+    std::lock_guard< std::mutex > _lck( m_path_mtx );
+    return m_strStablePath;
+}
+
+void CThreadedSerialPort::handle_read(const boost::system::error_code& error, size_t bytes_transferred, std::chrono::steady_clock::time_point tCompleted )
 {
+    CPendingOperation _op{ *this };
+
+    // Stop reading port
+    if( m_bStopThread ) {
+        return;
+    }
+
 	if( error.value() != 0 ) {
 
         if(    boost::asio::error::eof == error
             || boost::asio::error::bad_descriptor == error.value()
+            // Network transports: the peer is gone or TCP keepalive gave up
+            || boost::asio::error::connection_reset == error.value()
+            || boost::asio::error::connection_aborted == error.value()
+            || boost::asio::error::timed_out == error.value()
+            || boost::asio::error::not_connected == error.value()
         ) {
 			// The port is gone. Reopening required
 			if( m_fnLog ) {
@@ -305,9 +913,18 @@ void CThreadedSerialPort::handle_read(const boost::system::error_code& error, si
                 m_fnLog( false, 150, _msg.str() );
 			}
             _close();
+
+            if( m_fnConnection ) {
+                m_fnConnection( false, GetDevicePath() );
+            }
+
 			// The port is gone - cancel the read operation and try to reconnect in the background
-			m_timer.expires_from_now( boost::posix_time::seconds( 1 ) );
-			m_timer.async_wait( boost::bind(&CThreadedSerialPort::timer_handler, this ) );
+            m_bReconnecting = true;
+            m_nReconnectDelayMs = RECONNECT_DELAY_MIN_MS;
+            if( !CHotplugMonitor::Instance().Subscribe( this ) && m_fnLog ) {
+                m_fnLog( true, 0, L"Hot-plug notifications are not available. Reconnect relies on the retry timer" );
+            }
+            _async_wait_reconnect();
 			return;
 		}
 
@@ -323,182 +940,500 @@ void CThreadedSerialPort::handle_read(const boost::system::error_code& error, si
 		}
 	}
 
-	bool bReadFinished{ false };
 	if( bytes_transferred > 0 ) {
 
+        m_nReadCompletions.fetch_add( 1, std::memory_order_relaxed );
+        m_nBytesReceived.fetch_add( bytes_transferred, std::memory_order_relaxed );
+
 		if( m_fnLog ) {
             std::wostringstream logStream;
             logStream << L"< [SERIAL] " << bytes_transferred << L" bytes received " << std::endl << dump_bin_as_string( m_read_buffer.data(), std::min( m_read_buffer.size(), bytes_transferred ), 1 ) << std::endl;
             m_fnLog( false, 150, logStream.str() );
 		}
 
-		{
-			std::unique_lock< std::mutex > _lck( m_accum_mtx );
-            m_accumulator.insert( m_accumulator.end(), m_read_buffer.cbegin(), m_read_buffer.cbegin() + static_cast< long >( bytes_transferred ) );
+        // Our own transmission heard back on a half-duplex line goes no further
+        const size_t nEcho = _strip_echo( m_read_buffer.data(), bytes_transferred, tCompleted );
+        const uint8_t* pData = m_read_buffer.data() + nEcho;
+        const size_t nSize = bytes_transferred - nEcho;
+        if( 0 == nSize ) {
+            m_tLastRxByte.store( tCompleted, std::memory_order_relaxed );
+            _async_read_some();
+            return;
+        }
 
-            if( m_wait_for_incoming_data_size > 0 ) {
+        // The read completes once the last byte is in. On a UART the earlier ones came a character time apart,
+        // but not before the previous chunk ended. Other transports stamp the whole chunk with the completion
+        const auto nLater = static_cast< int64_t >( nSize - 1 );
+        SRxChunkTime chunkTime;
+        if( m_transport->GetTtyHandle() >= 0 ) {
+            chunkTime.characterTime = _character_time();
+        }
+        chunkTime.tFirstByte = tCompleted - chunkTime.characterTime * nLater;
+        const auto tLastRxByte = m_tLastRxByte.load( std::memory_order_relaxed );
+        if( chunkTime.tFirstByte < tLastRxByte ) {
+            chunkTime.tFirstByte = tLastRxByte;
+            chunkTime.characterTime = nLater > 0 ? ( tCompleted - tLastRxByte ) / nLater : std::chrono::nanoseconds{ 0 };
+        }
+        m_tLastRxByte.store( tCompleted, std::memory_order_relaxed );
 
-                if( m_fnLog ) {
-                    std::wostringstream logStream;
-                    logStream << L"< [SERIAL] " <<  m_wait_for_incoming_data_size << L" bytes expected" << std::endl;
-                    m_fnLog( false, 150, logStream.str() );
-                }
-				
-                // Test for WaitForIncomingData() finished
-                if( m_accumulator.size() >= m_wait_for_incoming_data_size ) {
-
-					bReadFinished = true;
-					
-					if( m_fnLog ) {
-                        std::wostringstream logStream;
-                        logStream << L"Read finished. Received: " << std::endl << dump_bin_as_string( { m_accumulator.cbegin(), m_accumulator.cend() }, 1 ) << std::endl;
-                        m_fnLog( false, 150, logStream.str() );
-					}
-
-					_lck.unlock();
-
-                    std::lock_guard< boost::mutex > _lock( m_wait_for_incoming_data_mtx );
-					m_wait_for_incoming_data.notify_all();
-				}
+        if( m_bFrameDecoding ) {
+            if( m_bResetDecoder.exchange( false ) ) {
+                m_decoder.Reset();
             }
-		}
-	}
-
-    // Stop reading port
-	if( m_bStopThread ) {
-		return;
-	}
-
-    // Adjusting the size of the handle_read buffer for the next upcoming read operation
-    size_t bufSize{ 0 };
-    {
-        std::lock_guard< std::mutex > _lck( m_accum_mtx );
-        if( bReadFinished || m_wait_for_incoming_data_size == 0 ) {
-
-            // In case WaitForIncomingData() is inactive
-            bufSize = 1;
+            m_decoder.Feed( pData, nSize, m_fnOnFrame, chunkTime );
+            _publish_decoder_statistics();
 
-        } else {
+            _async_read_some();
+            return;
+        }
 
-            // WaitForIncomingData() still active
-            if( m_wait_for_incoming_data_size <= m_accumulator.size() ) {
+        auto nStored = m_rx_ring.Write( pData, nSize );
+        if( nStored < nSize && m_fnLog ) {
+            std::wostringstream logStream;
+            logStream << L"< [SERIAL] RX ring is full. " << ( nSize - nStored ) << L" bytes dropped, "
+                      << m_rx_ring.GetOverflowCount() << L" bytes dropped in total" << std::endl;
+            m_fnLog( true, 0, logStream.str() );
+        }
 
-                if( m_fnLog ) {
-                    // This code are must be unreached
-                    std::wostringstream logStream;
-                    logStream << L"Logic error! WaitForIncomingData() is active but read expected size is less or equal to accumulator contents. m_wait_for_incoming_data_size = " << m_wait_for_incoming_data_size << L"; m_accumulator.size() = " << m_accumulator.size() << std::endl;
-                    m_fnLog( true, 0, logStream.str() );
-                }
-                bufSize = 1;
-            } else {
-                bufSize = m_wait_for_incoming_data_size - m_accumulator.size();
+        // The data is in the ring before the lock is taken, so a waiter either sees it or is already waiting
+        size_t nWaitSize{ 0 };
+        bool bNotify{ false };
+        {
+            std::lock_guard< std::mutex > _lock( m_wait_for_incoming_data_mtx );
+            m_LastRxTimestamps.tFirstByte = chunkTime.tFirstByte;
+            m_LastRxTimestamps.tLastByte = tCompleted;
+            nWaitSize = m_wait_for_incoming_data_size;
+            bNotify = nWaitSize > 0 && m_rx_ring.Size() >= nWaitSize;
+            if( bNotify ) {
+                m_tNotify = std::chrono::steady_clock::now();
             }
+        }
+        if( bNotify ) {
+            m_wait_for_incoming_data.notify_one();
+        }
 
-            if( bufSize > 0xffff ) {
-                std::wostringstream logStream;
-                logStream << L"bufSize = " << bufSize << L" is abnormal" << std::endl;
-                if( m_fnLog ) {
-                    m_fnLog( true, 0, logStream.str() );
-                }
-            }
+        if( nWaitSize > 0 && m_fnLog ) {
+            std::wostringstream logStream;
+            logStream << L"< [SERIAL] " << nWaitSize << L" bytes expected" << std::endl;
+            m_fnLog( false, 150, logStream.str() );
         }
-    }
+	}
 
-	m_read_buffer.resize( bufSize );
-	m_port.async_read_some( boost::asio::buffer( m_read_buffer.data(), bufSize ),
-		boost::bind(
-                &CThreadedSerialPort::handle_read, this,
-                boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred
-		)
-	);
+    // Stop reading port. An aborted read is not renewed either: the port was closed or
+    // timer_handler() reopened it and started reading anew
+	if( m_bStopThread || boost::asio::error::operation_aborted == error.value() ) {
+		return;
+	}
+
+    _async_read_some();
 }
 
 std::pair< bool, std::vector< uint8_t > > CThreadedSerialPort::WaitForIncomingData(size_t nBytesCount, uint32_t nTimeoutMillisec, bool bClearAccumulator )
 {
     std::pair< bool, std::vector< uint8_t > > response;
 
-    {
-        std::lock_guard< std::mutex > _lck( m_accum_mtx );
-        if( bClearAccumulator ) {
-            m_accumulator.clear();
-        }
+    response.second.resize( nBytesCount );
+    boost::system::error_code ec;
+    WaitForIncomingData( response.second.data(), nBytesCount, nTimeoutMillisec, ec, bClearAccumulator );
+    if( ec ) {
+        response.first = false;
+        response.second.clear();
+        return response;
+    }
+
+    response.first = true;
+    return response;
+}
 
-        // If already have all the data needed to be accumulated in buffer - prepare data for exit
-        if( nBytesCount <= m_accumulator.size() ) {
-            response.first = true;
-            response.second.insert( response.second.begin(), m_accumulator.cbegin(), m_accumulator.cbegin() + static_cast< long >( nBytesCount ) );
-            m_accumulator.erase( m_accumulator.begin(), m_accumulator.begin() + static_cast< long >( nBytesCount ) );
+size_t CThreadedSerialPort::WaitForIncomingData( uint8_t* pBuffer, size_t nBytesCount, uint32_t nTimeoutMillisec, boost::system::error_code& ec, bool bClearAccumulator )
+{
+    ec.clear();
 
-            return response;
-        }
+    if( bClearAccumulator ) {
+        _clear_rx();
     }
 
-    m_wait_for_incoming_data_size = nBytesCount;
-    if( m_wait_for_incoming_data_size > 0xFFFF ) {
+    if( nBytesCount > m_rx_ring.Capacity() ) {
         if( m_fnLog ){
             std::wostringstream logStream;
-            logStream << L"nBytesCount = " << nBytesCount << L" is abnormal" << std::endl;
+            logStream << L"nBytesCount = " << nBytesCount << L" exceeds the RX ring capacity " << m_rx_ring.Capacity() << std::endl;
             m_fnLog( true, 0, logStream.str() );
         }
+        ec = boost::asio::error::message_size;
+        return 0;
     }
 
+    // If already have all the data needed to be accumulated in buffer - prepare data for exit
+    if( nBytesCount <= m_rx_ring.Size() ) {
+        return m_rx_ring.Read( pBuffer, nBytesCount );
+    }
 
-    boost::unique_lock< boost::mutex > _lock( m_wait_for_incoming_data_mtx );
-    if( !m_wait_for_incoming_data.wait_for( _lock, boost::chrono::milliseconds( nTimeoutMillisec ),
-										   [&] { 
-													std::lock_guard< std::mutex > _lck( m_accum_mtx );
-													if( m_accumulator.size() >= nBytesCount ) {
-														return true;
-													} else {
-														return m_bStopThread;
-													}
-												}
-	) ) {
-
-		response.first = false;
-		return response;
+    std::unique_lock< std::mutex > _lock( m_wait_for_incoming_data_mtx );
+    m_wait_for_incoming_data_size = nBytesCount;
+    const bool bReady = m_wait_for_incoming_data.wait_for( _lock, std::chrono::milliseconds( nTimeoutMillisec ),
+                                                           [&] { return m_rx_ring.Size() >= nBytesCount || m_bStopThread; } );
+    m_wait_for_incoming_data_size = 0;
+    _account_wakeup();
+    _lock.unlock();
+
+    if( !bReady ) {
+        ec = boost::asio::error::timed_out;
+		return 0;
 	}
 
 	if( m_bStopThread ) {
-		response.first = false;
-		return response;
+        ec = boost::asio::error::operation_aborted;
+		return 0;
 	}
-		 
-	response.first = true;
-    {
-		std::lock_guard< std::mutex > _lck( m_accum_mtx );
-        response.second.insert( response.second.begin(), m_accumulator.cbegin(), m_accumulator.cbegin() + static_cast< long >( nBytesCount ) );
 
-        m_accumulator.erase( m_accumulator.begin(), m_accumulator.begin() + static_cast< long >( nBytesCount ) );
+    return m_rx_ring.Read( pBuffer, nBytesCount );
+}
 
-        m_wait_for_incoming_data_size = 0;
-	}
-	return response;
+void CThreadedSerialPort::EnableFrameDecoding( bool bEnable )
+{
+    m_bResetDecoder = true;
+    m_bFrameDecoding = bEnable;
 
+    std::lock_guard< std::mutex > _lock( m_wait_for_incoming_data_mtx );
+    m_nFramesCount = 0;
 }
 
-void CThreadedSerialPort::PurgeRxBuffer()
+void CThreadedSerialPort::_clear_rx()
 {
-    std::lock_guard< std::mutex > _lck( m_accum_mtx );
-    m_accumulator.clear();
+    m_rx_ring.Clear();
+    m_bResetDecoder = true;
+
+    std::lock_guard< std::mutex > _lock( m_wait_for_incoming_data_mtx );
+    m_nFramesCount = 0;
 }
 
-bool CThreadedSerialPort::TestOpen()
+void CThreadedSerialPort::_on_frame( const SSspFrame& frame )
+{
+    // The waiter taking this frame sees it counted
+    _publish_decoder_statistics();
+
+    if( m_fnLog ) {
+        std::wostringstream logStream;
+        logStream << L"< [SERIAL] frame decoded " << std::endl << dump_bin_as_string( frame.data, frame.length, 1 ) << std::endl;
+        m_fnLog( false, 150, logStream.str() );
+    }
+
+    bool bNotify{ false };
+    {
+        std::lock_guard< std::mutex > _lock( m_wait_for_incoming_data_mtx );
+        if( m_nFramesCount == FRAME_QUEUE_SIZE ) {
+            m_nFramesHead = ( m_nFramesHead + 1 ) % FRAME_QUEUE_SIZE;
+            --m_nFramesCount;
+        }
+        m_frames[ ( m_nFramesHead + m_nFramesCount ) % FRAME_QUEUE_SIZE ] = frame;
+        ++m_nFramesCount;
+
+        bNotify = m_nFrameWaiters > 0;
+        if( bNotify ) {
+            m_tNotify = std::chrono::steady_clock::now();
+        }
+    }
+
+    // Nobody is waiting - no syscall
+    if( bNotify ) {
+        m_wait_for_incoming_data.notify_all();
+    }
+}
+
+void CThreadedSerialPort::_publish_decoder_statistics()
 {
-    try {
+    const auto& stats = m_decoder.GetStatistics();
+    m_nDecodedFrames.store( stats.nFrames, std::memory_order_relaxed );
+    m_nDiscardedBytes.store( stats.nDiscardedBytes, std::memory_order_relaxed );
+    m_nFalseStarts.store( stats.nFalseStarts, std::memory_order_relaxed );
+    m_nOversizeLengths.store( stats.nOversizeLengths, std::memory_order_relaxed );
+    if( stats.nCrcErrors == m_nCrcErrors.load( std::memory_order_relaxed ) ) {
+        return;
+    }
+    m_nCrcErrors.store( stats.nCrcErrors, std::memory_order_relaxed );
+
+    if( m_fnLog ) {
+        m_fnLog( true, 0, L"< [SERIAL] frame CRC error" );
+    }
 
-        if( m_port.is_open() ) {
-            return  true;
+    bool bNotify{ false };
+    {
+        std::lock_guard< std::mutex > _lock( m_wait_for_incoming_data_mtx );
+        ++m_nCorruptedFrames;
+        bNotify = m_nFrameWaiters > 0;
+        if( bNotify ) {
+            m_tNotify = std::chrono::steady_clock::now();
         }
-        m_port.open( m_strPortName );
-        bool bResult = m_port.is_open();
-        m_port.close();
+    }
+    if( bNotify ) {
+        m_wait_for_incoming_data.notify_all();
+    }
+}
 
-        return bResult;
+void CThreadedSerialPort::_account_wakeup()
+{
+    if( m_tNotify == std::chrono::steady_clock::time_point{} ) {
+        return;
     }
-    catch( ... ) {
+
+    const uint64_t nNs = static_cast< uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - m_tNotify ).count() );
+    m_tNotify = {};
+
+    ++m_WakeupStatistics.nWakeups;
+    m_WakeupStatistics.nTotalNs += nNs;
+    m_WakeupStatistics.nMaxNs = std::max( m_WakeupStatistics.nMaxNs, nNs );
+}
+
+CThreadedSerialPort::SRxTimestamps CThreadedSerialPort::GetLastRxTimestamps()
+{
+    std::lock_guard< std::mutex > _lock( m_wait_for_incoming_data_mtx );
+    return m_LastRxTimestamps;
+}
+
+CThreadedSerialPort::SWakeupStatistics CThreadedSerialPort::GetWakeupStatistics()
+{
+    std::lock_guard< std::mutex > _lock( m_wait_for_incoming_data_mtx );
+    return m_WakeupStatistics;
+}
+
+bool CThreadedSerialPort::WaitForFrame( uint8_t nAddress, std::chrono::steady_clock::time_point deadline, SSspFrame& frame, boost::system::error_code& ec )
+{
+    ec.clear();
+
+    if( !m_bFrameDecoding ) {
+        ec = boost::asio::error::operation_not_supported;
         return false;
     }
+
+    std::unique_lock< std::mutex > _lock( m_wait_for_incoming_data_mtx );
+    const uint64_t nCorruptedFrames = m_nCorruptedFrames;
+    for( ; ; ) {
+        ++m_nFrameWaiters;
+        const bool bReady = m_wait_for_incoming_data.wait_until( _lock, deadline, [ this, nCorruptedFrames ] {
+            return m_nFramesCount > 0 || m_bStopThread || m_nCorruptedFrames != nCorruptedFrames;
+        } );
+        --m_nFrameWaiters;
+        _account_wakeup();
+
+        if( !bReady ) {
+            ec = boost::asio::error::timed_out;
+            return false;
+        }
+
+        if( m_bStopThread ) {
+            ec = boost::asio::error::operation_aborted;
+            return false;
+        }
+
+        // A frame decoded after the corrupted one still wins
+        if( m_nFramesCount == 0 ) {
+            ec = boost::system::errc::make_error_code( boost::system::errc::bad_message );
+            return false;
+        }
+
+        frame = m_frames[ m_nFramesHead ];
+        m_nFramesHead = ( m_nFramesHead + 1 ) % FRAME_QUEUE_SIZE;
+        --m_nFramesCount;
+
+        // is this packet for us ??
+        if( ANY_ADDRESS == nAddress || frame.Address() == nAddress ) {
+            return true;
+        }
+
+        m_nAddressMismatches.fetch_add( 1, std::memory_order_relaxed );
+        if( m_fnLog ) {
+            m_fnLog( true, 0, L"Address mismatch. Skip reply" );
+        }
+    }
+}
+
+void CThreadedSerialPort::SetLowLatencyProfile( bool bEnable )
+{
+    m_bLowLatencyRequested = bEnable;
+}
+
+CThreadedSerialPort::SLowLatencyState CThreadedSerialPort::GetLowLatencyState()
+{
+    std::lock_guard< std::mutex > _lck( m_low_latency_mtx );
+    return m_LowLatencyState;
+}
+
+void CThreadedSerialPort::_apply_low_latency_profile()
+{
+    SLowLatencyState state;
+    state.bRequested = true;
+
+    const int fd = m_transport->GetTtyHandle();
+
+    // Ask the driver to push received characters to the tty layer immediately
+    struct serial_struct serial{};
+    if( ::ioctl( fd, TIOCGSERIAL, &serial ) == 0 ) {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        if( ::ioctl( fd, TIOCSSERIAL, &serial ) == 0 && ::ioctl( fd, TIOCGSERIAL, &serial ) == 0 ) {
+            state.bAsyncLowLatency = ( serial.flags & ASYNC_LOW_LATENCY ) != 0;
+        }
+    }
+
+    // Raw mode keeping the line settings; a read returns as soon as a single byte is there
+    struct termios tio{};
+    if( ::tcgetattr( fd, &tio ) == 0 ) {
+        const tcflag_t cflag = tio.c_cflag;
+        ::cfmakeraw( &tio );
+        tio.c_cflag = cflag | CREAD | CLOCAL;
+        tio.c_cc[ VMIN ] = LOW_LATENCY_VMIN;
+        tio.c_cc[ VTIME ] = LOW_LATENCY_VTIME;
+        if( ::tcsetattr( fd, TCSANOW, &tio ) == 0 && ::tcgetattr( fd, &tio ) == 0 ) {
+            state.bRawTermios = ( tio.c_lflag & ICANON ) == 0;
+            state.nVMin = tio.c_cc[ VMIN ];
+            state.nVTime = tio.c_cc[ VTIME ];
+        }
+    }
+
+    // USB-serial adapters: the FTDI latency timer (16 ms by default) holds back short replies
+    const std::string strSysfsDir = _usb_serial_sysfs_dir( GetDevicePath() );
+    char szDriver[ PATH_MAX ];
+    auto nLen = ::readlink( ( strSysfsDir + "/driver" ).c_str(), szDriver, sizeof( szDriver ) - 1 );
+    if( nLen > 0 ) {
+        szDriver[ nLen ] = 0;
+        std::string strDriver{ szDriver };
+        state.strDriver = strDriver.substr( strDriver.rfind( '/' ) + 1 );
+    }
+
+    const std::string strLatencyTimer = strSysfsDir + "/latency_timer";
+    int nLatencyTimer = _read_sysfs_int( strLatencyTimer );
+    if( nLatencyTimer >= 0 ) {
+        std::lock_guard< std::mutex > _lck( m_low_latency_mtx );
+        if( m_nOriginalLatencyTimer < 0 ) {
+            m_nOriginalLatencyTimer = nLatencyTimer;
+        }
+    }
+    if( nLatencyTimer > LOW_LATENCY_TIMER_MS && _write_sysfs_int( strLatencyTimer, LOW_LATENCY_TIMER_MS ) ) {
+        nLatencyTimer = _read_sysfs_int( strLatencyTimer );
+    }
+    state.nLatencyTimerMs = nLatencyTimer;
+
+    if( m_fnLog ) {
+        std::wostringstream msg;
+        msg << L"Low latency profile for '" << utf8_to_wstring( m_strPortName ) << L"':" << std::endl;
+        msg << L"ASYNC_LOW_LATENCY: '" << state.bAsyncLowLatency << L"'" << std::endl;
+        msg << L"Raw termios: '" << state.bRawTermios << L"' VMIN: '" << static_cast< int >( state.nVMin ) << L"' VTIME: '" << static_cast< int >( state.nVTime ) << L"'" << std::endl;
+        msg << L"Driver: '" << utf8_to_wstring( state.strDriver ) << L"' latency timer: '" << state.nLatencyTimerMs << L"' ms";
+        m_fnLog( false, 150, msg.str() );
+    }
+
+    std::lock_guard< std::mutex > _lck( m_low_latency_mtx );
+    m_LowLatencyState = state;
+}
+
+void CThreadedSerialPort::_restore_latency_timer()
+{
+    std::lock_guard< std::mutex > _lck( m_low_latency_mtx );
+    if( m_nOriginalLatencyTimer >= 0 ) {
+        // The latency timer outlives the file descriptor, leave the adapter the way we found it
+        _write_sysfs_int( _usb_serial_sysfs_dir( GetDevicePath() ) + "/latency_timer", m_nOriginalLatencyTimer );
+        m_nOriginalLatencyTimer = -1;
+    }
+}
+
+void CThreadedSerialPort::_record_echo( const boost::asio::const_buffer* pBuffers, size_t nBuffers )
+{
+    if( !m_bEchoSuppression ) {
+        return;
+    }
+
+    size_t nBytes{ 0 };
+    for( size_t i = 0; i < nBuffers; ++i ) {
+        nBytes += pBuffers[ i ].size();
+    }
+    // Everything still expected is on the line by then, the queued bytes of the previous writes included.
+    // Set first, so the reader never sees the new bytes with the old deadline
+    m_tEchoDeadline = std::chrono::steady_clock::now() + _character_time() * static_cast< int64_t >( m_echo_ring.Size() + nBytes ) + ECHO_LATENCY;
+    for( size_t i = 0; i < nBuffers; ++i ) {
+        m_echo_ring.Write( static_cast< const uint8_t* >( pBuffers[ i ].data() ), pBuffers[ i ].size() );
+    }
+}
+
+size_t CThreadedSerialPort::_strip_echo( const uint8_t* pData, size_t nSize, std::chrono::steady_clock::time_point tCompleted )
+{
+    const CSpscRingBuffer::SSpans expected = m_echo_ring.Peek();
+    if( 0 == expected.size() ) {
+        return 0;
+    }
+
+    // Switched off meanwhile or too late: forget the echo. Only what was peeked, a writer may be adding more
+    if( !m_bEchoSuppression || tCompleted > m_tEchoDeadline.load() ) {
+        m_nEchoMissingBytes.fetch_add( expected.size(), std::memory_order_relaxed );
+        m_echo_ring.Consume( expected.size() );
+        return 0;
+    }
+
+    const size_t nCompare = std::min( nSize, expected.size() );
+    const size_t nFirst = std::min( nCompare, expected.nFirst );
+    bool bMatch = 0 == std::memcmp( pData, expected.pFirst, nFirst )
+               && 0 == std::memcmp( pData + nFirst, expected.pSecond, nCompare - nFirst );
+    if( bMatch ) {
+        m_echo_ring.Consume( nCompare );
+        m_nEchoBytes.fetch_add( nCompare, std::memory_order_relaxed );
+        return nCompare;
+    }
+
+    // Not our echo, or a corrupted one: the chunk goes to the decoder as is, which resynchronizes by itself
+    m_nEchoMismatches.fetch_add( 1, std::memory_order_relaxed );
+    m_nEchoMissingBytes.fetch_add( expected.size(), std::memory_order_relaxed );
+    m_echo_ring.Consume( expected.size() );
+    if( m_fnLog ) {
+        std::wostringstream logStream;
+        logStream << L"< [SERIAL] received bytes do not match the echo of the transmitted ones. " << expected.size() << L" echo bytes given up";
+        m_fnLog( true, 0, logStream.str() );
+    }
+    return 0;
+}
+
+CThreadedSerialPort::SEchoStatistics CThreadedSerialPort::GetEchoStatistics() const
+{
+    SEchoStatistics stats;
+    stats.nEchoBytes = m_nEchoBytes.load( std::memory_order_relaxed );
+    stats.nMismatches = m_nEchoMismatches.load( std::memory_order_relaxed );
+    stats.nMissingBytes = m_nEchoMissingBytes.load( std::memory_order_relaxed );
+    return stats;
+}
+
+CThreadedSerialPort::SFrameStatistics CThreadedSerialPort::GetFrameStatistics() const
+{
+    SFrameStatistics stats;
+    stats.decoder.nFrames = m_nDecodedFrames.load( std::memory_order_relaxed );
+    stats.decoder.nDiscardedBytes = m_nDiscardedBytes.load( std::memory_order_relaxed );
+    stats.decoder.nFalseStarts = m_nFalseStarts.load( std::memory_order_relaxed );
+    stats.decoder.nCrcErrors = m_nCrcErrors.load( std::memory_order_relaxed );
+    stats.decoder.nOversizeLengths = m_nOversizeLengths.load( std::memory_order_relaxed );
+    stats.nAddressMismatches = m_nAddressMismatches.load( std::memory_order_relaxed );
+    return stats;
+}
+
+CThreadedSerialPort::SRxStatistics CThreadedSerialPort::GetRxStatistics() const
+{
+    SRxStatistics stats;
+    stats.nReadCompletions = m_nReadCompletions.load( std::memory_order_relaxed );
+    stats.nBytesReceived = m_nBytesReceived.load( std::memory_order_relaxed );
+    stats.nOverflowBytes = GetRxOverflowCount();
+    return stats;
+}
+
+void CThreadedSerialPort::PurgeRxBuffer()
+{
+    _clear_rx();
+}
+
+bool CThreadedSerialPort::TestOpen()
+{
+    if( m_transport->IsOpen() ) {
+        return  true;
+    }
+    boost::system::error_code ec;
+    m_transport->Open( m_strPortName, ec );
+    m_transport->Close();
+
+    return !ec;
 }
 
 bool CThreadedSerialPort::Send(const std::vector< uint8_t >& vCommand, uint32_t /* nTimeoutUnused */ )
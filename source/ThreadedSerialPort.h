@@ -5,39 +5,180 @@
 #include <string>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <array>
 #include <deque>
+#include <future>
 #include <iomanip>
 #include <boost/asio.hpp>
-#include <boost/thread/condition_variable.hpp>
+#include "RingBuffer.h"
+#include "SSPFrameDecoder.h"
+#include "Transport.h"
 
 class CThreadedSerialPort {
+    friend class CHotplugMonitor;
 public:
     CThreadedSerialPort(std::string  strPortName, unsigned int baud, boost::asio::serial_port_base::parity::type parity, uint32_t nCharacterSize,
                         boost::asio::serial_port_base::stop_bits::type stopBits = boost::asio::serial_port_base::stop_bits::one
     );
+    // Any byte stream: serial, pty, in-memory pipe, TCP (see CTransport). The first constructor
+    // creates the transport by name with CTransport::Create()
+    explicit CThreadedSerialPort( std::unique_ptr< CTransport > pTransport, uint32_t baud = 9600,
+                                  boost::asio::serial_port_base::parity::type parity = boost::asio::serial_port_base::parity::none,
+                                  uint32_t nCharacterSize = 8,
+                                  boost::asio::serial_port_base::stop_bits::type stopBits = boost::asio::serial_port_base::stop_bits::one
+    );
     virtual ~CThreadedSerialPort();
 
+    CTransport& GetTransport() { return *m_transport; }
+
     void _setNV200WierdDeinitializationRequired() { m_bNV200WierdDeinitializationRequired = true; }
 
     // Open port, purge input buffer
     // TODO: to be deprecated. Move all the contents of this method to StartThread.
     bool Open( bool bPurgeRxBuffer = true );
-    bool IsOpen() { return m_port.is_open(); }
+    bool IsOpen() { return m_transport->IsOpen(); }
     bool ChangeSettings( uint32_t baud, uint32_t nCharacterSize, boost::asio::serial_port_base::parity::type parity );
     bool SetBaudrate( uint32_t baud );
+    uint32_t GetBaudrate() const { return m_nBaud; }
 
-    // Ensures the port is open then starts the thread
+    // Ensures the port is open then registers it within the shared reactor (see CSerialPortManager)
     // TODO: must return bool
     void StartThread( bool bPurgeRxBuffer = true );
 
-    // Stops the thread and also closes the port
+    // Unregisters the port from the shared reactor and also closes the port
     void StopThread();
 
     void SetLoggerHandler( std::function< void( bool bIsWarning, int lvl, const std::wstring& msg ) > fn ) { m_fnLog = std::move(fn); }
 
     std::pair< bool, std::vector< uint8_t > > WaitForIncomingData( size_t nBytesCount, uint32_t nTimeoutMillisec, bool bClearAccumulator = false );
 
+    // Allocation-free version: copies exactly nBytesCount bytes into pBuffer.
+    // Returns the number of bytes copied. On failure returns 0 and sets ec:
+    // timed_out, operation_aborted (the port is being stopped) or message_size (nBytesCount exceeds the RX ring)
+    size_t WaitForIncomingData( uint8_t* pBuffer, size_t nBytesCount, uint32_t nTimeoutMillisec, boost::system::error_code& ec, bool bClearAccumulator = false );
+
+    // Frame mode: the reader thread runs the SSP frame decoder itself and WaitForFrame() gets whole validated frames.
+    // While enabled the received bytes are not accumulated for WaitForIncomingData()
+    void EnableFrameDecoding( bool bEnable );
+    bool IsFrameDecodingEnabled() const { return m_bFrameDecoding; }
+
+    // Accepted by WaitForFrame() as "a frame from any address"
+    static constexpr uint8_t ANY_ADDRESS = 0xFF;
+
+    // Waits for the next complete frame from nAddress (or ANY_ADDRESS), frames from other addresses are skipped.
+    // On failure returns false and sets ec: timed_out, operation_aborted (the port is being stopped),
+    // operation_not_supported (frame mode is disabled) or bad_message (a frame failed the CRC while waiting:
+    // the reply was most likely corrupted, the caller can retry at once instead of waiting out the deadline)
+    bool WaitForFrame( uint8_t nAddress, std::chrono::steady_clock::time_point deadline, SSspFrame& frame, boost::system::error_code& ec );
+
     bool Write( const std::vector< uint8_t>& pData, bool bClearAccumulator = false );
+    bool Write( const uint8_t* pData, size_t nSize, bool bClearAccumulator = false );
+    // Gather write: the buffers go out in order via writev(), e.g. a header and a payload without joining them.
+    // Blocking writes are ordered with the queued AsyncWrite() ones. Must not be called from a write handler
+    bool Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, bool bClearAccumulator = false );
+
+    struct SWriteCompletion {
+        boost::system::error_code ec;
+        size_t nBytes{ 0 };
+        // When the last byte of the request is expected to leave the UART (kernel output queue drained)
+        std::chrono::steady_clock::time_point tDrained;
+    };
+    using write_handler_t = std::function< void( const SWriteCompletion& ) >;
+
+    // Blocking write which also reports when the UART sends the last byte. By default that is estimated from
+    // the kernel output queue (TIOCOUTQ) and the character time, without waiting. bWaitForDrain waits for it
+    // instead (tcdrain()) on a tty without flow control
+    bool Write( const uint8_t* pData, size_t nSize, SWriteCompletion& completion, bool bClearAccumulator = false, bool bWaitForDrain = false );
+
+    // Queues a copy of the data and returns immediately. The requests are sent in the order they were queued
+    // from any thread; adjacent small requests are coalesced into one writev(). The handler is called from
+    // a reactor thread. If the port is not started the handler is called at once with bad_descriptor
+    void AsyncWrite( const uint8_t* pData, size_t nSize, write_handler_t fnHandler );
+    std::future< SWriteCompletion > AsyncWrite( const uint8_t* pData, size_t nSize );
+
+    // Drops everything received but not consumed yet: bytes, partially decoded and queued frames
+    void PurgeRxBuffer();
+
+    // Opt-in low latency profile for USB-serial adapters. Applied on every (re)open of the port:
+    // ASYNC_LOW_LATENCY via TIOCSSERIAL, raw termios with VMIN/VTIME tuned for single byte reads and,
+    // where permitted, the minimal FTDI latency_timer in sysfs (restored on close)
+    void SetLowLatencyProfile( bool bEnable );
+
+    // Settings effectively applied by the last open. -1 / false means not supported or not permitted
+    struct SLowLatencyState {
+        bool bRequested{ false };
+        bool bAsyncLowLatency{ false };
+        bool bRawTermios{ false };
+        uint8_t nVMin{ 0 };
+        uint8_t nVTime{ 0 };
+        int nLatencyTimerMs{ -1 };
+        std::string strDriver;          // usb-serial driver, e.g. "ftdi_sio" or "ch341-uart"
+    };
+    SLowLatencyState GetLowLatencyState();
+
+    // Called from a reactor thread when the device disappears (bConnected == false) and when it is reopened.
+    // Must be set before StartThread()
+    using connection_handler_t = std::function< void( bool bConnected, const std::string& strDevicePath ) >;
+    void SetConnectionHandler( connection_handler_t fn ) { m_fnConnection = std::move( fn ); }
+
+    // The node actually opened last time and its stable /dev/serial/by-id alias (empty if there is none).
+    // Once the alias is known the port is reopened only through it, so a replugged adapter is found
+    // even if it comes back under another ttyUSBx name
+    std::string GetDevicePath();
+    std::string GetStablePortName();
+
+    // Number of received bytes dropped because nobody consumed them in time, by the port or its transport
+    uint64_t GetRxOverflowCount() const { return m_rx_ring.GetOverflowCount() + m_transport->GetRxOverflowCount(); }
+
+    struct SRxStatistics {
+        uint64_t nReadCompletions{ 0 };     // handle_read() calls which delivered data
+        uint64_t nBytesReceived{ 0 };
+        uint64_t nOverflowBytes{ 0 };
+    };
+    // Counters since the port object creation. nBytesReceived / nReadCompletions shows how well the reads are batched
+    SRxStatistics GetRxStatistics() const;
+
+    // Half-duplex lines (RS-485 converters without echo cancellation) hear every byte the port transmits.
+    // With the suppression on, the writers record what goes out and the reader drops its echo in bulk
+    // before the frame decoder or WaitForIncomingData() see it. A chunk which does not match the expected
+    // echo is passed on as is and the rest of the echo is forgotten, as is an echo which does not come in time
+    void SetEchoSuppression( bool bEnable ) { m_bEchoSuppression = bEnable; }
+    bool IsEchoSuppressionEnabled() const { return m_bEchoSuppression; }
+
+    struct SEchoStatistics {
+        uint64_t nEchoBytes{ 0 };           // received bytes dropped as the echo
+        uint64_t nMismatches{ 0 };          // chunks which did not match the expected echo
+        uint64_t nMissingBytes{ 0 };        // expected echo given up: mismatched, late or lost
+    };
+    // Counters since the port object creation
+    SEchoStatistics GetEchoStatistics() const;
+
+    // Frame mode counters since the port object creation. Line noise shows as discarded bytes, false starts
+    // and CRC errors, a slow or absent device as timeouts with none of them
+    struct SFrameStatistics {
+        CSSPFrameDecoder::SStatistics decoder;
+        uint64_t nAddressMismatches{ 0 };   // valid frames skipped by WaitForFrame() as from another address
+    };
+    SFrameStatistics GetFrameStatistics() const;
+
+    // Byte mode: arrival of the first and the last byte of the latest received chunk. The reader stamps
+    // the read completion and dates the earlier bytes back by the character time. Frames carry their own
+    struct SRxTimestamps {
+        std::chrono::steady_clock::time_point tFirstByte;
+        std::chrono::steady_clock::time_point tLastByte;
+    };
+    SRxTimestamps GetLastRxTimestamps();
+
+    // Time from the reader signalling the data / frame to the waiter running again
+    struct SWakeupStatistics {
+        uint64_t nWakeups{ 0 };
+        uint64_t nTotalNs{ 0 };
+        uint64_t nMaxNs{ 0 };
+    };
+    SWakeupStatistics GetWakeupStatistics();
 
 private:
 
@@ -45,23 +186,83 @@ private:
     // The access is restricted. To close port use public StopThread()
     bool _open( bool bPurgeRxBuffer = true );
     void _close();
+    // Unregisters a stopped port and wakes up its waiters
+    void _complete_stop();
+    // Drops the stale input of the tty: tcflush() until the line stays quiet, bounded
+    void _purge_rx_buffer();
+    bool _apply_line_settings();
 
     // Read stream organization
     void _start_port_async_reading();
-    void _fnReadingThread();
-    void handle_read( const boost::system::error_code& error, size_t bytes_transferred );
+    void _async_read_some();
+    void _async_wait_reconnect();
+    void handle_read( const boost::system::error_code& error, size_t bytes_transferred, std::chrono::steady_clock::time_point tCompleted );
     void timer_handler();
 
+    void _on_hotplug();
+    void _clear_rx();
+    void _apply_low_latency_profile();
+    void _restore_latency_timer();
+    void _on_frame( const SSspFrame& frame );
+    // Publishes the decoder counters for GetFrameStatistics() and wakes the frame waiters if a frame failed the CRC
+    void _publish_decoder_statistics();
+    // Echo suppression: records the transmitted bytes, called by the writers
+    void _record_echo( const boost::asio::const_buffer* pBuffers, size_t nBuffers );
+    // Called by the reader. Returns the number of leading bytes of the received chunk which are the echo
+    size_t _strip_echo( const uint8_t* pData, size_t nSize, std::chrono::steady_clock::time_point tCompleted );
+    // Called by a waiter under m_wait_for_incoming_data_mtx once woken
+    void _account_wakeup();
+
+    // Write queue organization
+    void _start_write();
+    void handle_write( const boost::system::error_code& error, size_t bytes_transferred );
+    void _fail_write_queue( const boost::system::error_code& error );
+    bool _write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, bool bClearAccumulator, SWriteCompletion* pCompletion, bool bWaitForDrain = false );
+    std::chrono::steady_clock::time_point _tx_drained_time();
+    std::chrono::steady_clock::time_point _wait_tx_drained();
+    std::chrono::nanoseconds _character_time() const;
+
+    // Runs fn within the port's strand, tracked as a pending operation
+    template< typename F >
+    void _post( F fn )
+    {
+        {
+            std::lock_guard< std::mutex > _lck( m_pending_mtx );
+            ++m_nPendingOperations;
+        }
+        m_strand.post( [ this, fn ]() mutable {
+            CPendingOperation _op{ *this };
+            fn();
+        } );
+    }
+
+    // Every handler queued to the shared reactor holds the guard so StopThread() can wait them all
+    class CPendingOperation {
+    public:
+        explicit CPendingOperation( CThreadedSerialPort& port ) : m_port( port ) {}
+        ~CPendingOperation();
+    private:
+        CThreadedSerialPort& m_port;
+    };
+
 private:
 
-    std::thread m_thread;
-    bool m_bStopThread{ false };
+    std::atomic< bool > m_bRegistered{ false };
+    std::atomic< bool > m_bStopThread{ false };
+
+    std::mutex m_pending_mtx;
+    std::condition_variable m_pending_cv;
+    size_t m_nPendingOperations{ 0 };
+    // StopThread() was called from a reactor thread, guarded by m_pending_mtx
+    bool m_bStopDeferred{ false };
 
     std::function< void( bool bIsWarning, int lvl, const std::wstring& msg ) > m_fnLog;
 
-    boost::asio::io_service m_io_service;
-    boost::asio::serial_port m_port;
+    std::unique_ptr< CTransport > m_transport;
+    // Reconnect timer. It is the fallback only: the retry comes earlier when CHotplugMonitor reports a new tty node
     boost::asio::deadline_timer m_timer;
+    // Serializes the handlers of this port among the reactor threads
+    boost::asio::io_service::strand m_strand;
 
     std::string m_strPortName;
     uint32_t m_nBaud;
@@ -70,20 +271,103 @@ private:
     boost::asio::serial_port_base::stop_bits::type m_StopBits;
     boost::asio::serial_port_base::flow_control::type m_FlowControl;
 
-    // handle_read operation buffer
+    std::mutex m_path_mtx;
+    std::string m_strDevicePath;
+    std::string m_strStablePath;
+
+    // Reconnect state. Accessed from the strand only: handle_read() takes errors through the strand
+    // even on a transport with its own reactor
+    static constexpr uint32_t RECONNECT_DELAY_MIN_MS = 100;
+    static constexpr uint32_t RECONNECT_DELAY_MAX_MS = 5000;
+    bool m_bReconnecting{ false };
+    uint32_t m_nReconnectDelayMs{ RECONNECT_DELAY_MIN_MS };
+    connection_handler_t m_fnConnection;
+
+    // handle_read operation buffer. Every read takes up to READ_BUFFER_SIZE bytes available in the kernel at once
+    static constexpr size_t READ_BUFFER_SIZE = 4096;
     std::vector< uint8_t > m_read_buffer;
+    // Written by the reader on every read, kept away from the waiter's cache line
+    alignas( 64 ) std::atomic< uint64_t > m_nReadCompletions{ 0 };
+    std::atomic< uint64_t > m_nBytesReceived{ 0 };
+    // Arrival of the last received byte. Written by handle_read() on whichever thread delivers the data:
+    // the strand or, with HasOwnReactor(), the transport's reactor thread
+    std::atomic< std::chrono::steady_clock::time_point > m_tLastRxByte{ std::chrono::steady_clock::time_point{} };
+
+    // Accumulating data for WaitForIncomingData(). The reader thread is the producer, the waiter is the consumer.
+    // Unsolicited bytes are bounded by the ring capacity
+    static constexpr size_t RX_RING_CAPACITY = 8192;
+    CSpscRingBuffer m_rx_ring;
+
+    // Transmitted bytes whose echo is expected. The writer in progress is the producer, the reader the
+    // consumer. The deadline follows the latest write
+    static constexpr size_t ECHO_RING_CAPACITY = 8192;
+    std::atomic< bool > m_bEchoSuppression{ false };
+    CSpscRingBuffer m_echo_ring;
+    std::atomic< std::chrono::steady_clock::time_point > m_tEchoDeadline{ std::chrono::steady_clock::time_point{} };
+    std::atomic< uint64_t > m_nEchoBytes{ 0 };
+    std::atomic< uint64_t > m_nEchoMismatches{ 0 };
+    std::atomic< uint64_t > m_nEchoMissingBytes{ 0 };
 
-    // Accumulating data for WaitForIncomingData()
-    std::mutex m_accum_mtx;
-    std::deque< uint8_t > m_accumulator;
-    size_t m_wait_for_incoming_data_size{ 0 };
+    // Frame mode. The decoder is owned by the reader, others request its reset via m_bResetDecoder
+    std::atomic< bool > m_bFrameDecoding{ false };
+    std::atomic< bool > m_bResetDecoder{ false };
+    CSSPFrameDecoder m_decoder;
+    CSSPFrameDecoder::frame_handler_t m_fnOnFrame;
+    // Copies of the decoder counters for the other threads, written by the reader
+    std::atomic< uint64_t > m_nDecodedFrames{ 0 };
+    std::atomic< uint64_t > m_nDiscardedBytes{ 0 };
+    std::atomic< uint64_t > m_nFalseStarts{ 0 };
+    std::atomic< uint64_t > m_nCrcErrors{ 0 };
+    std::atomic< uint64_t > m_nOversizeLengths{ 0 };
+    std::atomic< uint64_t > m_nAddressMismatches{ 0 };
 
-    boost::mutex m_wait_for_incoming_data_mtx;
-    boost::condition_variable m_wait_for_incoming_data;
+    // Reader to waiter handoff: the only lock and condition variable on the reply path, for both
+    // the byte and the frame modes. Starts a cache line of its own, the frames queue follows
+    alignas( 64 ) std::mutex m_wait_for_incoming_data_mtx;
+    std::condition_variable m_wait_for_incoming_data;
+    // Guarded by m_wait_for_incoming_data_mtx
+    size_t m_wait_for_incoming_data_size{ 0 };      // bytes the WaitForIncomingData() caller needs, 0 if none
+    size_t m_nFrameWaiters{ 0 };
+    uint64_t m_nCorruptedFrames{ 0 };               // CRC failures, WaitForFrame() gives up on a change
+    std::chrono::steady_clock::time_point m_tNotify;
+    SRxTimestamps m_LastRxTimestamps;
+    SWakeupStatistics m_WakeupStatistics;
+
+    // Decoded frames not taken by WaitForFrame() yet. Guarded by m_wait_for_incoming_data_mtx.
+    // When full the oldest frame is dropped
+    static constexpr size_t FRAME_QUEUE_SIZE = 4;
+    size_t m_nFramesHead{ 0 };
+    size_t m_nFramesCount{ 0 };
+    std::array< SSspFrame, FRAME_QUEUE_SIZE > m_frames;
+
+    struct SWriteRequest {
+        std::vector< uint8_t > vData;       // owned copy for AsyncWrite()
+        boost::asio::const_buffer buffer;   // vData or the memory of a blocked Write() caller
+        write_handler_t fnHandler;
+    };
+    // Requests are coalesced up to these limits into one writev()
+    static constexpr size_t WRITE_BATCH_MAX_BUFFERS = 16;
+    static constexpr size_t WRITE_BATCH_MAX_BYTES = 4096;
+
+    alignas( 64 ) std::mutex m_write_mtx;
+    std::deque< SWriteRequest > m_write_queue;
+    bool m_bWriteInProgress{ false };
+    // The batch being written: the first m_nWriteBatch requests of m_write_queue. Accessed from the strand only,
+    // the write completions are wrapped into it whatever the transport
+    size_t m_nWriteBatch{ 0 };
+    std::vector< boost::asio::const_buffer > m_write_buffers;
+    std::vector< SWriteRequest > m_write_completed;
 
     bool m_bNV200WierdDeinitializationRequired{ false };
 
-    void PurgeRxBuffer();
+    // Low latency profile
+    static constexpr uint8_t LOW_LATENCY_VMIN = 1;
+    static constexpr uint8_t LOW_LATENCY_VTIME = 0;
+    static constexpr int LOW_LATENCY_TIMER_MS = 1;
+    std::atomic< bool > m_bLowLatencyRequested{ false };
+    std::mutex m_low_latency_mtx;
+    SLowLatencyState m_LowLatencyState;
+    int m_nOriginalLatencyTimer{ -1 };
 
     bool TestOpen();
 
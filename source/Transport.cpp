@@ -0,0 +1,44 @@
+#include "Transport.h"
+#include "SerialTransport.h"
+#include "EpollSerialTransport.h"
+#include "UringSerialTransport.h"
+#include "PtyTransport.h"
+#include "TcpTransport.h"
+#include "Rfc2217Transport.h"
+
+std::atomic< CTransport::ESerialBackend > CTransport::m_eSerialBackend{ CTransport::ESerialBackend::Asio };
+
+std::unique_ptr< CTransport > CTransport::Create( boost::asio::io_service& io_service, const std::string& strName )
+{
+    static const std::string strTcp{ "tcp://" };
+    static const std::string strRfc2217{ "rfc2217://" };
+    static const std::string strPty{ "pty://" };
+
+    // tcp://host:port, rfc2217://host:port
+    for( const auto* pScheme : { &strTcp, &strRfc2217 } ) {
+        if( 0 != strName.compare( 0, pScheme->size(), *pScheme ) ) {
+            continue;
+        }
+        std::string strAddress = strName.substr( pScheme->size() );
+        auto nColon = strAddress.rfind( ':' );
+        if( nColon == std::string::npos ) {
+            break;
+        }
+        if( pScheme == &strTcp ) {
+            return std::unique_ptr< CTransport >( new CTcpTransport( io_service, strAddress.substr( 0, nColon ), strAddress.substr( nColon + 1 ) ) );
+        }
+        return std::unique_ptr< CTransport >( new CRfc2217Transport( io_service, strAddress.substr( 0, nColon ), strAddress.substr( nColon + 1 ) ) );
+    }
+
+    if( strName == strPty ) {
+        return std::unique_ptr< CTransport >( new CPtyTransport( io_service ) );
+    }
+
+    if( m_eSerialBackend == ESerialBackend::IoUring && CUringSerialTransport::IsSupported() ) {
+        return std::unique_ptr< CTransport >( new CUringSerialTransport( strName ) );
+    }
+    if( m_eSerialBackend != ESerialBackend::Asio ) {
+        return std::unique_ptr< CTransport >( new CEpollSerialTransport( strName ) );
+    }
+    return std::unique_ptr< CTransport >( new CSerialTransport( io_service, strName ) );
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <functional>
+#include <boost/asio.hpp>
+
+// Byte stream underneath CThreadedSerialPort: a serial port, a pseudo-terminal, an in-process pipe or a TCP socket.
+// All the asynchronous handlers are dispatched through the io_service the transport was created with.
+// Not thread safe: CThreadedSerialPort serializes the calls within its strand
+class CTransport {
+public:
+    // Implementation of the serial device nodes
+    enum class ESerialBackend {
+        Asio,           // boost::asio::serial_port on the shared io_service (CSerialTransport)
+        Epoll,          // raw termios and a native epoll reactor (CEpollSerialTransport)
+        IoUring         // raw termios and a shared io_uring (CUringSerialTransport), Epoll where the kernel lacks it
+    };
+
+    using io_handler_t = std::function< void( const boost::system::error_code& error, size_t bytes_transferred ) >;
+
+    struct SLineSettings {
+        uint32_t nBaud{ 9600 };
+        uint32_t nCharacterSize{ 8 };
+        boost::asio::serial_port_base::parity::type parity{ boost::asio::serial_port_base::parity::none };
+        boost::asio::serial_port_base::stop_bits::type stopBits{ boost::asio::serial_port_base::stop_bits::one };
+        boost::asio::serial_port_base::flow_control::type flowControl{ boost::asio::serial_port_base::flow_control::none };
+    };
+
+    // "tcp://host:port" - raw TCP socket, "rfc2217://host:port" - Telnet COM port control,
+    // "pty://" - a new pseudo-terminal, anything else is a serial device path
+    static std::unique_ptr< CTransport > Create( boost::asio::io_service& io_service, const std::string& strName );
+
+    // Backend of the serial transports created afterwards. Default is Asio
+    static void SetSerialBackend( ESerialBackend eBackend ) { m_eSerialBackend = eBackend; }
+    static ESerialBackend GetSerialBackend() { return m_eSerialBackend; }
+
+    virtual ~CTransport() = default;
+
+    // The name the transport was created with, e.g. "/dev/ttyUSB0" or "tcp://10.0.0.5:4001"
+    virtual std::string GetName() const = 0;
+
+    // strDevicePath is GetName() or an alias of it (see CThreadedSerialPort::GetStablePortName()).
+    // Transports that are not device nodes ignore it
+    virtual void Open( const std::string& strDevicePath, boost::system::error_code& ec ) = 0;
+    virtual bool IsOpen() const = 0;
+    virtual void Close() = 0;
+
+    // Completes the pending operations with operation_aborted
+    virtual void Cancel() = 0;
+
+    // No-op for the transports without a line (pty master, memory pipe, raw TCP)
+    virtual void SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec ) = 0;
+
+    virtual void AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler ) = 0;
+
+    // The buffers must stay valid until the handler is called. The handler gets either an error or the total size
+    virtual void AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler ) = 0;
+
+    // Blocking gather write. Returns the number of bytes written
+    virtual size_t Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec ) = 0;
+
+    // File descriptor of the tty for termios/ioctl tuning, -1 if the transport is not a tty
+    virtual int GetTtyHandle() { return -1; }
+
+    // True if the handlers are called from a reactor thread of the transport itself rather than the io_service.
+    // CThreadedSerialPort then handles the received data right there instead of hopping to its strand
+    virtual bool HasOwnReactor() const { return false; }
+
+    // Received bytes the transport itself dropped because no read took them in time
+    virtual uint64_t GetRxOverflowCount() const { return 0; }
+
+private:
+    static std::atomic< ESerialBackend > m_eSerialBackend;
+};
+
+// Adapts a caller-owned array of buffers to the asio ConstBufferSequence requirements
+class CConstBufferList {
+public:
+    using value_type = boost::asio::const_buffer;
+    using const_iterator = const boost::asio::const_buffer*;
+
+    CConstBufferList( const boost::asio::const_buffer* pBuffers, size_t nBuffers ) : m_pBegin{ pBuffers }, m_pEnd{ pBuffers + nBuffers } {}
+
+    const_iterator begin() const { return m_pBegin; }
+    const_iterator end() const { return m_pEnd; }
+
+private:
+    const_iterator m_pBegin;
+    const_iterator m_pEnd;
+};
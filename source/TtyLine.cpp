@@ -0,0 +1,147 @@
+#include "TtyLine.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+    boost::system::error_code _errno_error()
+    {
+        return boost::system::error_code( errno, boost::system::system_category() );
+    }
+
+    speed_t _speed( uint32_t nBaud )
+    {
+        switch( nBaud ) {
+            case 1200: return B1200;
+            case 2400: return B2400;
+            case 4800: return B4800;
+            case 9600: return B9600;
+            case 19200: return B19200;
+            case 38400: return B38400;
+            case 57600: return B57600;
+            case 115200: return B115200;
+            case 230400: return B230400;
+            case 460800: return B460800;
+            case 500000: return B500000;
+            case 576000: return B576000;
+            case 921600: return B921600;
+            case 1000000: return B1000000;
+            case 1152000: return B1152000;
+            case 1500000: return B1500000;
+            case 2000000: return B2000000;
+            case 2500000: return B2500000;
+            case 3000000: return B3000000;
+            case 3500000: return B3500000;
+            case 4000000: return B4000000;
+            default: return B0;
+        }
+    }
+}
+
+int OpenRawTty( const std::string& strDevicePath, bool bBlocking, boost::system::error_code& ec )
+{
+    // Opened non-blocking in any case: a modem line without carrier would block the open itself
+    int fd = ::open( strDevicePath.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC );
+    if( fd < 0 ) {
+        ec = _errno_error();
+        return -1;
+    }
+
+    termios tio{};
+    if( ::tcgetattr( fd, &tio ) != 0 ) {
+        ec = _errno_error();
+        ::close( fd );
+        return -1;
+    }
+    tio.c_iflag &= ~( IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON );
+    tio.c_oflag &= ~OPOST;
+    tio.c_lflag &= ~( ECHO | ECHONL | ICANON | ISIG | IEXTEN );
+    tio.c_cflag &= ~( CSIZE | PARENB );
+    tio.c_cflag |= CS8 | CREAD | CLOCAL;
+    tio.c_iflag |= IGNPAR;
+    if( ::tcsetattr( fd, TCSANOW, &tio ) != 0 ) {
+        ec = _errno_error();
+        ::close( fd );
+        return -1;
+    }
+
+    if( bBlocking ) {
+        int nFlags = ::fcntl( fd, F_GETFL );
+        if( nFlags < 0 || ::fcntl( fd, F_SETFL, nFlags & ~O_NONBLOCK ) != 0 ) {
+            ec = _errno_error();
+            ::close( fd );
+            return -1;
+        }
+    }
+    return fd;
+}
+
+void SetTtyLineSettings( int fd, const CTransport::SLineSettings& settings, boost::system::error_code& ec )
+{
+    termios tio{};
+    if( ::tcgetattr( fd, &tio ) != 0 ) {
+        ec = _errno_error();
+        return;
+    }
+
+    const speed_t speed = _speed( settings.nBaud );
+    if( speed == B0 || settings.nCharacterSize < 5 || settings.nCharacterSize > 8 ) {
+        ec = boost::asio::error::invalid_argument;
+        return;
+    }
+    ::cfsetispeed( &tio, speed );
+    ::cfsetospeed( &tio, speed );
+
+    static const tcflag_t characterSizes[] = { CS5, CS6, CS7, CS8 };
+    tio.c_cflag = ( tio.c_cflag & ~CSIZE ) | characterSizes[ settings.nCharacterSize - 5 ];
+
+    switch( settings.parity ) {
+        case boost::asio::serial_port_base::parity::none:
+            tio.c_iflag |= IGNPAR;
+            tio.c_cflag &= ~( PARENB | PARODD );
+            break;
+        case boost::asio::serial_port_base::parity::even:
+            tio.c_iflag &= ~( IGNPAR | PARMRK );
+            tio.c_iflag |= INPCK;
+            tio.c_cflag |= PARENB;
+            tio.c_cflag &= ~PARODD;
+            break;
+        case boost::asio::serial_port_base::parity::odd:
+            tio.c_iflag &= ~( IGNPAR | PARMRK );
+            tio.c_iflag |= INPCK;
+            tio.c_cflag |= ( PARENB | PARODD );
+            break;
+    }
+
+    switch( settings.stopBits ) {
+        case boost::asio::serial_port_base::stop_bits::one:
+            tio.c_cflag &= ~CSTOPB;
+            break;
+        case boost::asio::serial_port_base::stop_bits::two:
+            tio.c_cflag |= CSTOPB;
+            break;
+        default:
+            ec = boost::asio::error::operation_not_supported;
+            return;
+    }
+
+    switch( settings.flowControl ) {
+        case boost::asio::serial_port_base::flow_control::none:
+            tio.c_iflag &= ~( IXOFF | IXON );
+            tio.c_cflag &= ~CRTSCTS;
+            break;
+        case boost::asio::serial_port_base::flow_control::software:
+            tio.c_iflag |= IXOFF | IXON;
+            tio.c_cflag &= ~CRTSCTS;
+            break;
+        case boost::asio::serial_port_base::flow_control::hardware:
+            tio.c_iflag &= ~( IXOFF | IXON );
+            tio.c_cflag |= CRTSCTS;
+            break;
+    }
+
+    if( ::tcsetattr( fd, TCSANOW, &tio ) != 0 ) {
+        ec = _errno_error();
+    }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include "Transport.h"
+
+// termios helpers of the native serial transports (CEpollSerialTransport, CUringSerialTransport)
+
+// Opens the device node as a raw 8 bit line, the same as boost::asio::serial_port sets up on open.
+// The descriptor is non-blocking unless bBlocking. Returns -1 and sets ec on failure
+int OpenRawTty( const std::string& strDevicePath, bool bBlocking, boost::system::error_code& ec );
+
+// Standard Bxxx speeds only
+void SetTtyLineSettings( int fd, const CTransport::SLineSettings& settings, boost::system::error_code& ec );
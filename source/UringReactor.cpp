@@ -0,0 +1,377 @@
+#include "UringReactor.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+    const unsigned RING_ENTRIES = 512;
+
+    // Registered read slots, fewer if RLIMIT_MEMLOCK does not allow that many
+    const size_t MAX_SLOTS = 256;
+    const size_t MIN_SLOTS = 16;
+
+    // Ring of provided buffers shared by the multishot reads of all the ports
+    const unsigned PROVIDED_BUFFERS = 256;
+    const size_t PROVIDED_BUFFER_SIZE = 1024;
+    const uint16_t BUFFER_GROUP = 1;
+
+    // IORING_OP_READ_MULTISHOT, Linux 6.7. Newer than the uapi headers this may be built against;
+    // the opcodes are ABI and the probe tells whether the running kernel has it
+    const uint8_t OP_READ_MULTISHOT = IORING_OP_SENDMSG_ZC + 1;
+
+    int _io_uring_setup( unsigned nEntries, io_uring_params* pParams )
+    {
+        return static_cast< int >( ::syscall( __NR_io_uring_setup, nEntries, pParams ) );
+    }
+
+    int _io_uring_enter( int fd, unsigned nSubmit, unsigned nMinComplete, unsigned nFlags )
+    {
+        return static_cast< int >( ::syscall( __NR_io_uring_enter, fd, nSubmit, nMinComplete, nFlags, nullptr, 0 ) );
+    }
+
+    int _io_uring_register( int fd, unsigned nOpcode, void* pArg, unsigned nArgs )
+    {
+        return static_cast< int >( ::syscall( __NR_io_uring_register, fd, nOpcode, pArg, nArgs ) );
+    }
+
+    // Deferred call of CUringReactor::Post(), completed by a NOP
+    class CPostedOperation : public CUringReactor::IOperation {
+    public:
+        explicit CPostedOperation( std::function< void() > fn ) : m_fn{ std::move( fn ) } {}
+
+        void OnComplete( int, uint32_t ) override
+        {
+            m_fn();
+            delete this;
+        }
+
+    private:
+        std::function< void() > m_fn;
+    };
+}
+
+CUringReactor* CUringReactor::Instance()
+{
+    // Never destroyed: the transports may still be closed from the other singletons' destructors
+    static CUringReactor* pReactor = [] {
+        CUringReactor* pNew = new CUringReactor;
+        if( pNew->m_ring < 0 ) {
+            delete pNew;
+            return static_cast< CUringReactor* >( nullptr );
+        }
+        return pNew;
+    }();
+    return pReactor;
+}
+
+CUringReactor::CUringReactor()
+{
+    if( _setup() ) {
+        m_thread = CLibraryThread( EThreadRole::Reactor, [ this ] { _fnRunner(); }, "-uring" );
+    }
+}
+
+bool CUringReactor::_setup()
+{
+    io_uring_params params{};
+    m_ring = _io_uring_setup( RING_ENTRIES, &params );
+    if( m_ring < 0 ) {
+        return false;
+    }
+
+    auto fail = [ this ] {
+        if( m_pSqes ) {
+            ::munmap( m_pSqes, m_nSqesSize );
+            m_pSqes = nullptr;
+        }
+        if( m_pRings ) {
+            ::munmap( m_pRings, m_nRingsSize );
+            m_pRings = nullptr;
+        }
+        ::close( m_ring );
+        m_ring = -1;
+        return false;
+    };
+
+    // Linux 5.4+: both rings in one mapping
+    if( !( params.features & IORING_FEAT_SINGLE_MMAP ) ) {
+        return fail();
+    }
+    m_nRingsSize = std::max( params.sq_off.array + params.sq_entries * sizeof( unsigned ),
+                             params.cq_off.cqes + params.cq_entries * sizeof( io_uring_cqe ) );
+    m_pRings = ::mmap( nullptr, m_nRingsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQ_RING );
+    if( m_pRings == MAP_FAILED ) {
+        m_pRings = nullptr;
+        return fail();
+    }
+    m_nSqesSize = params.sq_entries * sizeof( io_uring_sqe );
+    m_pSqes = ::mmap( nullptr, m_nSqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ring, IORING_OFF_SQES );
+    if( m_pSqes == MAP_FAILED ) {
+        m_pSqes = nullptr;
+        return fail();
+    }
+
+    uint8_t* pRings = static_cast< uint8_t* >( m_pRings );
+    m_pSqHead = reinterpret_cast< unsigned* >( pRings + params.sq_off.head );
+    m_pSqTail = reinterpret_cast< unsigned* >( pRings + params.sq_off.tail );
+    m_nSqMask = *reinterpret_cast< unsigned* >( pRings + params.sq_off.ring_mask );
+    m_nSqEntries = params.sq_entries;
+    m_pSqeArray = static_cast< io_uring_sqe* >( m_pSqes );
+    m_pCqHead = reinterpret_cast< unsigned* >( pRings + params.cq_off.head );
+    m_pCqTail = reinterpret_cast< unsigned* >( pRings + params.cq_off.tail );
+    m_nCqMask = *reinterpret_cast< unsigned* >( pRings + params.cq_off.ring_mask );
+    m_pCqes = pRings + params.cq_off.cqes;
+
+    // The submission entries are used in ring order, so the indirection array is the identity
+    unsigned* pArray = reinterpret_cast< unsigned* >( pRings + params.sq_off.array );
+    for( unsigned i = 0; i < params.sq_entries; ++i ) {
+        pArray[ i ] = i;
+    }
+
+    // Linux 5.6+ has the probe and everything the transport cannot do without
+    std::vector< uint8_t > vProbe( sizeof( io_uring_probe ) + 256 * sizeof( io_uring_probe_op ) );
+    io_uring_probe* pProbe = reinterpret_cast< io_uring_probe* >( vProbe.data() );
+    if( _io_uring_register( m_ring, IORING_REGISTER_PROBE, pProbe, 256 ) < 0 ) {
+        return fail();
+    }
+    auto supported = [ pProbe ]( uint8_t nOp ) {
+        return nOp <= pProbe->last_op && ( pProbe->ops[ nOp ].flags & IO_URING_OP_SUPPORTED );
+    };
+    if( !supported( IORING_OP_NOP ) || !supported( IORING_OP_READ ) || !supported( IORING_OP_WRITEV ) ||
+        !supported( IORING_OP_ASYNC_CANCEL ) || !supported( IORING_OP_LINK_TIMEOUT ) ) {
+        return fail();
+    }
+
+    if( supported( IORING_OP_READ_FIXED ) ) {
+        _setup_buffers();
+    }
+
+    if( supported( OP_READ_MULTISHOT ) ) {
+        const size_t nRingSize = PROVIDED_BUFFERS * sizeof( io_uring_buf );
+        void* pMemory = ::mmap( nullptr, nRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if( pMemory != MAP_FAILED ) {
+            io_uring_buf_reg reg{};
+            reg.ring_addr = reinterpret_cast< uint64_t >( pMemory );
+            reg.ring_entries = PROVIDED_BUFFERS;
+            reg.bgid = BUFFER_GROUP;
+            if( _io_uring_register( m_ring, IORING_REGISTER_PBUF_RING, &reg, 1 ) == 0 ) {
+                m_pBufferRing = static_cast< io_uring_buf_ring* >( pMemory );
+                m_vProvided.resize( PROVIDED_BUFFERS * PROVIDED_BUFFER_SIZE );
+                for( unsigned i = 0; i < PROVIDED_BUFFERS; ++i ) {
+                    RecycleProvidedBuffer( i << IORING_CQE_BUFFER_SHIFT );
+                }
+            } else {
+                ::munmap( pMemory, nRingSize );
+            }
+        }
+    }
+    return true;
+}
+
+void CUringReactor::_setup_buffers()
+{
+    // Pinned memory: halve the count until it fits the locked memory limit
+    for( size_t nSlots = MAX_SLOTS; nSlots >= MIN_SLOTS; nSlots /= 2 ) {
+        m_vSlots.resize( nSlots * SLOT_SIZE );
+        std::vector< iovec > vIov( nSlots );
+        for( size_t i = 0; i < nSlots; ++i ) {
+            vIov[ i ].iov_base = GetSlot( static_cast< int >( i ) );
+            vIov[ i ].iov_len = SLOT_SIZE;
+        }
+        if( _io_uring_register( m_ring, IORING_REGISTER_BUFFERS, vIov.data(), static_cast< unsigned >( nSlots ) ) == 0 ) {
+            for( size_t i = nSlots; i > 0; --i ) {
+                m_vFreeSlots.push_back( static_cast< int >( i - 1 ) );
+            }
+            return;
+        }
+    }
+    m_vSlots.clear();
+    m_vSlots.shrink_to_fit();
+}
+
+int CUringReactor::AcquireSlot()
+{
+    std::lock_guard< std::mutex > _lck( m_slots_mtx );
+    if( m_vFreeSlots.empty() ) {
+        return -1;
+    }
+    int nSlot = m_vFreeSlots.back();
+    m_vFreeSlots.pop_back();
+    return nSlot;
+}
+
+void CUringReactor::ReleaseSlot( int nSlot )
+{
+    if( nSlot >= 0 ) {
+        std::lock_guard< std::mutex > _lck( m_slots_mtx );
+        m_vFreeSlots.push_back( nSlot );
+    }
+}
+
+const uint8_t* CUringReactor::GetProvidedBuffer( uint32_t nFlags ) const
+{
+    return m_vProvided.data() + ( nFlags >> IORING_CQE_BUFFER_SHIFT ) * PROVIDED_BUFFER_SIZE;
+}
+
+void CUringReactor::RecycleProvidedBuffer( uint32_t nFlags )
+{
+    const uint16_t nId = static_cast< uint16_t >( nFlags >> IORING_CQE_BUFFER_SHIFT );
+    // The entries start at the ring itself. Not through bufs[]: in C++ the empty struct the uapi
+    // header puts in front of the flexible array takes room and shifts it
+    io_uring_buf& buf = reinterpret_cast< io_uring_buf* >( m_pBufferRing )[ m_nProvidedTail & ( PROVIDED_BUFFERS - 1 ) ];
+    buf.addr = reinterpret_cast< uint64_t >( m_vProvided.data() + nId * PROVIDED_BUFFER_SIZE );
+    buf.len = PROVIDED_BUFFER_SIZE;
+    buf.bid = nId;
+    __atomic_store_n( &m_pBufferRing->tail, ++m_nProvidedTail, __ATOMIC_RELEASE );
+}
+
+void CUringReactor::ReadMultishot( int fd, IOperation* pOperation )
+{
+    std::lock_guard< std::mutex > _lck( m_sq_mtx );
+    io_uring_sqe* pSqe = _get_sqe();
+    pSqe->opcode = OP_READ_MULTISHOT;
+    pSqe->fd = fd;
+    pSqe->flags = IOSQE_BUFFER_SELECT;
+    pSqe->buf_group = BUFFER_GROUP;
+    pSqe->user_data = reinterpret_cast< uint64_t >( pOperation );
+    _submit( false );
+}
+
+void CUringReactor::ReadFixed( int fd, int nSlot, size_t nSize, IOperation* pOperation )
+{
+    std::lock_guard< std::mutex > _lck( m_sq_mtx );
+    io_uring_sqe* pSqe = _get_sqe();
+    pSqe->opcode = IORING_OP_READ_FIXED;
+    pSqe->fd = fd;
+    pSqe->addr = reinterpret_cast< uint64_t >( GetSlot( nSlot ) );
+    pSqe->len = static_cast< uint32_t >( std::min( nSize, SLOT_SIZE ) );
+    pSqe->buf_index = static_cast< uint16_t >( nSlot );
+    pSqe->user_data = reinterpret_cast< uint64_t >( pOperation );
+    _submit( false );
+}
+
+void CUringReactor::Read( int fd, void* pData, size_t nSize, IOperation* pOperation )
+{
+    std::lock_guard< std::mutex > _lck( m_sq_mtx );
+    io_uring_sqe* pSqe = _get_sqe();
+    pSqe->opcode = IORING_OP_READ;
+    pSqe->fd = fd;
+    pSqe->addr = reinterpret_cast< uint64_t >( pData );
+    pSqe->len = static_cast< uint32_t >( nSize );
+    pSqe->user_data = reinterpret_cast< uint64_t >( pOperation );
+    _submit( false );
+}
+
+void CUringReactor::Writev( int fd, const iovec* pIov, unsigned nIov, const __kernel_timespec* pTimeout, IOperation* pOperation )
+{
+    std::lock_guard< std::mutex > _lck( m_sq_mtx );
+    io_uring_sqe* pSqe = _get_sqe();
+    pSqe->opcode = IORING_OP_WRITEV;
+    pSqe->fd = fd;
+    pSqe->addr = reinterpret_cast< uint64_t >( pIov );
+    pSqe->len = nIov;
+    pSqe->user_data = reinterpret_cast< uint64_t >( pOperation );
+
+    if( pTimeout ) {
+        pSqe->flags = IOSQE_IO_LINK;
+        // Its own completion has no user data and is skipped: the write reports the expiry as -ECANCELED
+        io_uring_sqe* pTimeoutSqe = _get_sqe();
+        pTimeoutSqe->opcode = IORING_OP_LINK_TIMEOUT;
+        pTimeoutSqe->fd = -1;
+        pTimeoutSqe->addr = reinterpret_cast< uint64_t >( pTimeout );
+        pTimeoutSqe->len = 1;
+    }
+    _submit( false );
+}
+
+void CUringReactor::Cancel( IOperation* pOperation )
+{
+    std::lock_guard< std::mutex > _lck( m_sq_mtx );
+    io_uring_sqe* pSqe = _get_sqe();
+    pSqe->opcode = IORING_OP_ASYNC_CANCEL;
+    pSqe->fd = -1;
+    pSqe->addr = reinterpret_cast< uint64_t >( pOperation );
+    _submit( false );
+}
+
+void CUringReactor::Post( std::function< void() > fn )
+{
+    std::lock_guard< std::mutex > _lck( m_sq_mtx );
+    io_uring_sqe* pSqe = _get_sqe();
+    pSqe->opcode = IORING_OP_NOP;
+    pSqe->fd = -1;
+    pSqe->user_data = reinterpret_cast< uint64_t >( new CPostedOperation( std::move( fn ) ) );
+    _submit( false );
+}
+
+io_uring_sqe* CUringReactor::_get_sqe()
+{
+    while( m_nSqTail - __atomic_load_n( m_pSqHead, __ATOMIC_ACQUIRE ) >= m_nSqEntries ) {
+        // Full: the kernel has not taken the earlier entries yet
+        _submit( true );
+        std::this_thread::yield();
+    }
+
+    // Published to the kernel by _submit(), once filled
+    io_uring_sqe* pSqe = &m_pSqeArray[ m_nSqTail++ & m_nSqMask ];
+    std::memset( pSqe, 0, sizeof( *pSqe ) );
+    return pSqe;
+}
+
+void CUringReactor::_submit( bool bNow )
+{
+    m_nUnsubmitted += m_nSqTail - *m_pSqTail;
+    __atomic_store_n( m_pSqTail, m_nSqTail, __ATOMIC_RELEASE );
+
+    // The reactor thread submits with its next wait
+    if( m_nUnsubmitted == 0 || ( !bNow && IsReactorThread() ) ) {
+        return;
+    }
+    int nResult;
+    do {
+        nResult = _io_uring_enter( m_ring, m_nUnsubmitted, 0, 0 );
+    } while( nResult < 0 && errno == EINTR );
+    if( nResult > 0 ) {
+        m_nUnsubmitted -= std::min( static_cast< unsigned >( nResult ), m_nUnsubmitted );
+    }
+}
+
+void CUringReactor::_fnRunner()
+{
+    io_uring_cqe* pCqes = static_cast< io_uring_cqe* >( m_pCqes );
+
+    for( ; ; ) {
+        unsigned nSubmit;
+        {
+            std::lock_guard< std::mutex > _lck( m_sq_mtx );
+            nSubmit = m_nUnsubmitted;
+            m_nUnsubmitted = 0;
+        }
+
+        int nResult = _io_uring_enter( m_ring, nSubmit, 1, IORING_ENTER_GETEVENTS );
+        if( nResult < 0 || static_cast< unsigned >( nResult ) < nSubmit ) {
+            // Whatever the kernel did not take goes with the next call
+            std::lock_guard< std::mutex > _lck( m_sq_mtx );
+            m_nUnsubmitted += nSubmit - ( nResult < 0 ? 0 : static_cast< unsigned >( nResult ) );
+        }
+        if( nResult < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY ) {
+            return;
+        }
+
+        unsigned nHead = *m_pCqHead;
+        while( nHead != __atomic_load_n( m_pCqTail, __ATOMIC_ACQUIRE ) ) {
+            const io_uring_cqe cqe = pCqes[ nHead & m_nCqMask ];
+            __atomic_store_n( m_pCqHead, ++nHead, __ATOMIC_RELEASE );
+
+            // No user data: a linked timeout or a cancel request
+            if( cqe.user_data ) {
+                reinterpret_cast< IOperation* >( cqe.user_data )->OnComplete( cqe.res, cqe.flags );
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <sys/uio.h>
+#include <linux/time_types.h>
+#include "LibraryThread.h"
+
+struct io_uring_sqe;
+struct io_uring_buf_ring;
+
+// Native reactor of CUringSerialTransport: one io_uring for all the ports, set up with the raw system calls
+// and reaped by one library thread (EThreadRole::Reactor, "ssp-io-uring"). Any thread may submit; the
+// submissions of the reactor thread itself go to the kernel with its next wait, in one system call.
+// Started on the first use and never stopped - the process exit takes the thread down
+class CUringReactor {
+public:
+    // An operation in flight, submitted with its address as the user data. OnComplete() is called from
+    // the reactor thread for every completion: once, or per chunk of a multishot read while
+    // IORING_CQE_F_MORE is set. The operation must stay alive until its last completion
+    class IOperation {
+    public:
+        virtual ~IOperation() = default;
+        virtual void OnComplete( int nResult, uint32_t nFlags ) = 0;
+    };
+
+    // Size of the registered read slots
+    static constexpr size_t SLOT_SIZE = 4096;
+
+    // nullptr if the kernel has no io_uring or lacks the basic operations - the caller falls back
+    static CUringReactor* Instance();
+
+    CUringReactor( const CUringReactor& ) = delete;
+    CUringReactor& operator=( const CUringReactor& ) = delete;
+
+    // Multishot reads into the ring of provided buffers (Linux 6.7+)
+    bool HasMultishotRead() const { return m_pBufferRing != nullptr; }
+    // Registered slots for the single-shot reads (IORING_OP_READ_FIXED)
+    bool HasRegisteredBuffers() const { return !m_vSlots.empty(); }
+    bool IsReactorThread() const { return m_thread.IsCurrent(); }
+
+    // -1 when all the slots are taken
+    int AcquireSlot();
+    void ReleaseSlot( int nSlot );
+    uint8_t* GetSlot( int nSlot ) { return m_vSlots.data() + static_cast< size_t >( nSlot ) * SLOT_SIZE; }
+
+    // The provided buffer holding the data of a multishot read completion. Reactor thread only,
+    // the buffer has to go back to the ring before OnComplete() returns
+    const uint8_t* GetProvidedBuffer( uint32_t nFlags ) const;
+    void RecycleProvidedBuffer( uint32_t nFlags );
+
+    void ReadMultishot( int fd, IOperation* pOperation );
+    void ReadFixed( int fd, int nSlot, size_t nSize, IOperation* pOperation );
+    void Read( int fd, void* pData, size_t nSize, IOperation* pOperation );
+    // pTimeout, if not null, is linked to the write and cancels it on expiry. It has to stay valid
+    // until the operation completes, as the iovecs do
+    void Writev( int fd, const iovec* pIov, unsigned nIov, const __kernel_timespec* pTimeout, IOperation* pOperation );
+    // The operation completes with -ECANCELED unless it is about to complete anyway
+    void Cancel( IOperation* pOperation );
+
+    // Runs fn on the reactor thread, e.g. a completion which must not be called from the initiating function
+    void Post( std::function< void() > fn );
+
+private:
+    CUringReactor();
+
+    bool _setup();
+    void _setup_buffers();
+
+    // Both under m_sq_mtx
+    io_uring_sqe* _get_sqe();
+    void _submit( bool bNow );
+
+    void _fnRunner();
+
+private:
+    int m_ring{ -1 };
+
+    void* m_pRings{ nullptr };
+    size_t m_nRingsSize{ 0 };
+    void* m_pSqes{ nullptr };
+    size_t m_nSqesSize{ 0 };
+
+    // Submission queue, shared by the submitting threads
+    std::mutex m_sq_mtx;
+    unsigned* m_pSqHead{ nullptr };
+    unsigned* m_pSqTail{ nullptr };
+    unsigned m_nSqMask{ 0 };
+    unsigned m_nSqEntries{ 0 };
+    unsigned m_nSqTail{ 0 };        // ahead of *m_pSqTail by the entries being filled
+    unsigned m_nUnsubmitted{ 0 };
+    io_uring_sqe* m_pSqeArray{ nullptr };
+
+    // Completion queue, reactor thread only
+    unsigned* m_pCqHead{ nullptr };
+    unsigned* m_pCqTail{ nullptr };
+    unsigned m_nCqMask{ 0 };
+    void* m_pCqes{ nullptr };
+
+    std::mutex m_slots_mtx;
+    std::vector< uint8_t > m_vSlots;
+    std::vector< int > m_vFreeSlots;
+
+    io_uring_buf_ring* m_pBufferRing{ nullptr };
+    std::vector< uint8_t > m_vProvided;
+    uint16_t m_nProvidedTail{ 0 };
+
+    CLibraryThread m_thread;
+};
@@ -0,0 +1,495 @@
+#include "UringSerialTransport.h"
+#include "TtyLine.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <unistd.h>
+#include <linux/io_uring.h>
+
+namespace {
+    // How long the previous descriptor's cancelled operations may take to complete on reopen
+    const auto DRAIN_TIMEOUT = std::chrono::seconds( 1 );
+
+    // A write waits for the room in the kernel output queue, then for its own bytes to go out.
+    // On top of both at the line speed: this much slack for the flow control and the scheduling
+    const size_t TTY_OUTPUT_QUEUE_SIZE = 4096;
+    const auto WRITE_TIMEOUT_MARGIN = std::chrono::seconds( 1 );
+
+    // Received bytes kept for the next AsyncReadSome(). The rest is dropped and counted, like the port's RX ring does
+    const size_t BACKLOG_CAPACITY = 8192;
+
+    void _post( CUringReactor& reactor, CTransport::io_handler_t fnHandler, const boost::system::error_code& ec, size_t nBytes )
+    {
+        if( fnHandler ) {
+            reactor.Post( [ fnHandler, ec, nBytes ] { fnHandler( ec, nBytes ); } );
+        }
+    }
+
+    boost::system::error_code _result_error( int nResult )
+    {
+        return boost::system::error_code( -nResult, boost::system::system_category() );
+    }
+
+    // Drops the fully written iovecs and trims the partially written one
+    void _consume( std::vector< iovec >& vIov, size_t nBytes )
+    {
+        size_t nDone{ 0 };
+        while( nDone < vIov.size() && nBytes >= vIov[ nDone ].iov_len ) {
+            nBytes -= vIov[ nDone ].iov_len;
+            ++nDone;
+        }
+        vIov.erase( vIov.begin(), vIov.begin() + nDone );
+        if( nBytes > 0 && !vIov.empty() ) {
+            vIov.front().iov_base = static_cast< uint8_t* >( vIov.front().iov_base ) + nBytes;
+            vIov.front().iov_len -= nBytes;
+        }
+    }
+}
+
+bool CUringSerialTransport::IsSupported()
+{
+    return CUringReactor::Instance() != nullptr;
+}
+
+CUringSerialTransport::CUringSerialTransport( std::string strName )
+    : m_strName{ std::move( strName ) }
+    , m_channel{ std::make_shared< CChannel >() }
+{
+}
+
+CUringSerialTransport::~CUringSerialTransport()
+{
+    Close();
+}
+
+void CUringSerialTransport::Open( const std::string& strDevicePath, boost::system::error_code& ec )
+{
+    std::unique_lock< std::mutex > _lck( m_channel->mtx );
+    if( m_channel->fd >= 0 ) {
+        ec = boost::asio::error::already_open;
+        return;
+    }
+
+    // The operations of the previous descriptor have been cancelled on Close(), their completions
+    // are due any moment. Not to be waited for on the reactor thread, which delivers them
+    if( !m_channel->IsIdle() &&
+        ( m_channel->reactor.IsReactorThread() ||
+          !m_channel->cv.wait_for( _lck, DRAIN_TIMEOUT, [ this ] { return m_channel->IsIdle(); } ) ) ) {
+        ec = boost::asio::error::try_again;
+        return;
+    }
+
+    // Blocking: io_uring waits for a blocking descriptor by polling it, while a non-blocking one
+    // would just complete the reads with EAGAIN
+    int fd = OpenRawTty( strDevicePath, true, ec );
+    if( fd < 0 ) {
+        return;
+    }
+    m_channel->fd = fd;
+    m_channel->vBacklog.clear();
+    m_channel->readError = {};
+    // The read is armed by the first AsyncReadSome(): until then the input stays in the tty, where the
+    // owner can still flush it. The multishot read then runs on whether a read is pending or not
+}
+
+bool CUringSerialTransport::IsOpen() const
+{
+    return m_channel->fd >= 0;
+}
+
+void CUringSerialTransport::Close()
+{
+    std::unique_lock< std::mutex > _lck( m_channel->mtx );
+    const int fd = m_channel->fd;
+    if( fd < 0 ) {
+        return;
+    }
+
+    // The pending handlers get operation_aborted from the cancelled completions. The kernel keeps
+    // its own reference to the file until then. A read not submitted yet is dropped when its turn comes
+    if( m_channel->read.bInFlight && !m_channel->bReadArmPending ) {
+        m_channel->reactor.Cancel( &m_channel->read );
+    }
+    if( m_channel->asyncWrite.bInFlight ) {
+        m_channel->asyncWriteState.bAborted = true;
+        m_channel->reactor.Cancel( &m_channel->asyncWrite );
+    }
+    if( m_channel->syncWrite.bInFlight ) {
+        m_channel->syncWriteState.bAborted = true;
+        m_channel->reactor.Cancel( &m_channel->syncWrite );
+    }
+    m_channel->fd = -1;
+
+    // The plain writev() of a blocking Write() has no operation to cancel. It finishes at the line speed
+    m_channel->cv.wait( _lck, [ this ] { return 0 == m_channel->nPlainWriters; } );
+    ::close( fd );
+}
+
+void CUringSerialTransport::Cancel()
+{
+    std::lock_guard< std::mutex > _lck( m_channel->mtx );
+    // A multishot read without a pending handler has nothing to abort, it goes on filling the backlog.
+    // Neither has one the kernel has not got yet: its handler is aborted right away
+    if( m_channel->read.bInFlight && m_channel->fnRead ) {
+        if( m_channel->bReadArmPending ) {
+            _post( m_channel->reactor, std::move( m_channel->fnRead ), boost::asio::error::operation_aborted, 0 );
+            m_channel->fnRead = nullptr;
+        } else {
+            m_channel->reactor.Cancel( &m_channel->read );
+        }
+    }
+    if( m_channel->asyncWrite.bInFlight ) {
+        m_channel->asyncWriteState.bAborted = true;
+        m_channel->reactor.Cancel( &m_channel->asyncWrite );
+    }
+}
+
+void CUringSerialTransport::SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec )
+{
+    std::lock_guard< std::mutex > _lck( m_channel->mtx );
+    const int fd = m_channel->fd;
+    if( fd < 0 ) {
+        ec = boost::asio::error::bad_descriptor;
+        return;
+    }
+
+    SetTtyLineSettings( fd, settings, ec );
+    if( !ec ) {
+        m_channel->nBaud = settings.nBaud;
+        m_channel->bFlowControl = settings.flowControl != boost::asio::serial_port_base::flow_control::none;
+    }
+}
+
+void CUringSerialTransport::AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler )
+{
+    std::unique_lock< std::mutex > _lck( m_channel->mtx );
+    CChannel& channel = *m_channel;
+    if( channel.fd < 0 ) {
+        _lck.unlock();
+        _post( channel.reactor, std::move( fnHandler ), boost::asio::error::bad_descriptor, 0 );
+        return;
+    }
+
+    if( !channel.vBacklog.empty() ) {
+        const size_t nRead = std::min( channel.vBacklog.size(), buffer.size() );
+        std::memcpy( buffer.data(), channel.vBacklog.data(), nRead );
+        channel.vBacklog.erase( channel.vBacklog.begin(), channel.vBacklog.begin() + nRead );
+        _lck.unlock();
+        _post( channel.reactor, std::move( fnHandler ), {}, nRead );
+        return;
+    }
+    if( channel.readError ) {
+        auto ec = channel.readError;
+        channel.readError = {};
+        _lck.unlock();
+        _post( channel.reactor, std::move( fnHandler ), ec, 0 );
+        return;
+    }
+
+    channel.readBuffer = buffer;
+    channel.fnRead = std::move( fnHandler );
+    channel.StartRead();
+}
+
+void CUringSerialTransport::AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler )
+{
+    std::unique_lock< std::mutex > _lck( m_channel->mtx );
+    CChannel& channel = *m_channel;
+    if( channel.fd < 0 ) {
+        _lck.unlock();
+        _post( channel.reactor, std::move( fnHandler ), boost::asio::error::bad_descriptor, 0 );
+        return;
+    }
+
+    SWrite& write = channel.asyncWriteState;
+    write.vIov.clear();
+    for( size_t i = 0; i < nBuffers; ++i ) {
+        write.vIov.push_back( { const_cast< void* >( pBuffers[ i ].data() ), pBuffers[ i ].size() } );
+    }
+    write.nWritten = 0;
+    write.error = {};
+    write.fnHandler = std::move( fnHandler );
+    write.bAborted = false;
+    write.bDone = false;
+    channel.StartWrite( channel.asyncWrite, write );
+}
+
+size_t CUringSerialTransport::Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec )
+{
+    std::lock_guard< std::mutex > _sync_lck( m_sync_write_mtx );
+    std::unique_lock< std::mutex > _lck( m_channel->mtx );
+    CChannel& channel = *m_channel;
+    if( channel.fd < 0 ) {
+        ec = boost::asio::error::bad_descriptor;
+        return 0;
+    }
+
+    SWrite& write = channel.syncWriteState;
+    write.vIov.clear();
+    for( size_t i = 0; i < nBuffers; ++i ) {
+        write.vIov.push_back( { const_cast< void* >( pBuffers[ i ].data() ), pBuffers[ i ].size() } );
+    }
+    write.nWritten = 0;
+    write.error = {};
+    write.fnHandler = nullptr;
+    write.bAborted = false;
+    write.bDone = false;
+
+    // Without flow control the line drains at its speed and a plain blocking write cannot hang. It also
+    // saves the caller the wake-up of the reactor for the completion. The reactor thread cannot wait
+    // for its own completions anyway
+    if( !channel.bFlowControl || channel.reactor.IsReactorThread() ) {
+        // Close() keeps the descriptor open until the writer is done
+        const int fd = channel.fd;
+        ++channel.nPlainWriters;
+        _lck.unlock();
+        while( !write.vIov.empty() ) {
+            ssize_t nResult = ::writev( fd, write.vIov.data(), static_cast< int >( std::min< size_t >( write.vIov.size(), IOV_MAX ) ) );
+            if( nResult < 0 ) {
+                if( errno == EINTR ) {
+                    continue;
+                }
+                ec = boost::system::error_code( errno, boost::system::system_category() );
+                break;
+            }
+            write.nWritten += static_cast< size_t >( nResult );
+            _consume( write.vIov, static_cast< size_t >( nResult ) );
+        }
+
+        _lck.lock();
+        --channel.nPlainWriters;
+        _lck.unlock();
+        channel.cv.notify_all();
+        return write.nWritten;
+    }
+
+    channel.StartWrite( channel.syncWrite, write );
+    channel.cv.wait( _lck, [ &write ] { return write.bDone; } );
+    ec = write.error;
+    return write.nWritten;
+}
+
+int CUringSerialTransport::GetTtyHandle()
+{
+    return m_channel->fd;
+}
+
+void CUringSerialTransport::COperation::OnComplete( int nResult, uint32_t nFlags )
+{
+    ( m_channel.*m_pfnComplete )( *this, nResult, nFlags );
+}
+
+CUringSerialTransport::CChannel::CChannel()
+    : reactor( *CUringReactor::Instance() )
+    , read( *this, &CChannel::OnRead )
+    , asyncWrite( *this, &CChannel::OnWrite )
+    , syncWrite( *this, &CChannel::OnWrite )
+{
+    if( !reactor.HasMultishotRead() && reactor.HasRegisteredBuffers() ) {
+        nSlot = reactor.AcquireSlot();
+    }
+}
+
+CUringSerialTransport::CChannel::~CChannel()
+{
+    reactor.ReleaseSlot( nSlot );
+}
+
+void CUringSerialTransport::CChannel::StartRead()
+{
+    if( read.bInFlight || fd < 0 ) {
+        return;
+    }
+
+    if( reactor.HasMultishotRead() ) {
+        // io_uring runs the completion work of a read waiting for data on the thread which submitted it.
+        // The multishot read lasts as long as the descriptor, so it is submitted by the reactor thread,
+        // which waits for the completions anyway: from any other thread that one would be woken per chunk
+        if( reactor.IsReactorThread() ) {
+            reactor.ReadMultishot( fd, &read );
+        } else {
+            bReadArmPending = true;
+            reactor.Post( [ pChannel = shared_from_this() ] { pChannel->ArmMultishotRead(); } );
+        }
+    } else {
+        // No more than the caller takes, so that nothing is left over
+        const size_t nSize = std::min( readBuffer.size(), CUringReactor::SLOT_SIZE );
+        if( nSlot >= 0 ) {
+            reactor.ReadFixed( fd, nSlot, nSize, &read );
+        } else {
+            vReadBuffer.resize( nSize );
+            reactor.Read( fd, vReadBuffer.data(), nSize, &read );
+        }
+    }
+    read.bInFlight = true;
+    if( !pSelf ) {
+        pSelf = shared_from_this();
+    }
+}
+
+void CUringSerialTransport::CChannel::ArmMultishotRead()
+{
+    std::shared_ptr< CChannel > pHold;
+    io_handler_t fnDone;
+    {
+        std::lock_guard< std::mutex > _lck( mtx );
+        bReadArmPending = false;
+        if( fd >= 0 ) {
+            reactor.ReadMultishot( fd, &read );
+            return;
+        }
+
+        // Closed before the read got to the kernel
+        read.bInFlight = false;
+        fnDone = std::move( fnRead );
+        fnRead = nullptr;
+        if( IsIdle() ) {
+            pHold = std::move( pSelf );
+            cv.notify_all();
+        }
+    }
+
+    if( fnDone ) {
+        fnDone( boost::asio::error::operation_aborted, 0 );
+    }
+}
+
+void CUringSerialTransport::CChannel::StartWrite( COperation& operation, SWrite& write )
+{
+    // The remaining bytes plus a full output queue ahead of them, 10 bits per character
+    size_t nBytes{ TTY_OUTPUT_QUEUE_SIZE };
+    for( const auto& iov : write.vIov ) {
+        nBytes += iov.iov_len;
+    }
+    const auto timeout = WRITE_TIMEOUT_MARGIN + std::chrono::microseconds( nBytes * 10 * 1000000ull / std::max< uint32_t >( nBaud, 1 ) );
+    const auto nSeconds = std::chrono::duration_cast< std::chrono::seconds >( timeout );
+    write.timeout.tv_sec = nSeconds.count();
+    write.timeout.tv_nsec = std::chrono::duration_cast< std::chrono::nanoseconds >( timeout - nSeconds ).count();
+
+    reactor.Writev( fd, write.vIov.data(), static_cast< unsigned >( std::min< size_t >( write.vIov.size(), IOV_MAX ) ), &write.timeout, &operation );
+    operation.bInFlight = true;
+    if( !pSelf ) {
+        pSelf = shared_from_this();
+    }
+}
+
+void CUringSerialTransport::CChannel::AppendBacklog( const uint8_t* pData, size_t nSize )
+{
+    const size_t nToAppend = std::min( nSize, BACKLOG_CAPACITY - std::min( vBacklog.size(), BACKLOG_CAPACITY ) );
+    vBacklog.insert( vBacklog.end(), pData, pData + nToAppend );
+    if( nToAppend < nSize ) {
+        nBacklogOverflow.fetch_add( nSize - nToAppend, std::memory_order_relaxed );
+    }
+}
+
+void CUringSerialTransport::CChannel::OnRead( COperation& operation, int nResult, uint32_t nFlags )
+{
+    // Released after the lock: the channel may go with it
+    std::shared_ptr< CChannel > pHold;
+    io_handler_t fnDone;
+    boost::system::error_code ec;
+    size_t nDone{ 0 };
+    {
+        std::lock_guard< std::mutex > _lck( mtx );
+        const bool bMultishot = reactor.HasMultishotRead();
+        const bool bLast = !bMultishot || !( nFlags & IORING_CQE_F_MORE );
+
+        if( nResult > 0 ) {
+            const uint8_t* pData = bMultishot ? reactor.GetProvidedBuffer( nFlags ) :
+                                   nSlot >= 0 ? reactor.GetSlot( nSlot ) : vReadBuffer.data();
+            const size_t nData = static_cast< size_t >( nResult );
+            if( fnRead && vBacklog.empty() ) {
+                nDone = std::min( nData, readBuffer.size() );
+                std::memcpy( readBuffer.data(), pData, nDone );
+                vBacklog.clear();
+                AppendBacklog( pData + nDone, nData - nDone );
+                fnDone = std::move( fnRead );
+                fnRead = nullptr;
+            } else {
+                AppendBacklog( pData, nData );
+            }
+            if( bMultishot ) {
+                reactor.RecycleProvidedBuffer( nFlags );
+            }
+        } else if( nResult == 0 ) {
+            // Hang-up: the device is gone
+            readError = boost::asio::error::eof;
+        } else if( nResult == -ECANCELED ) {
+            if( fnRead && bLast ) {
+                fnDone = std::move( fnRead );
+                fnRead = nullptr;
+                ec = boost::asio::error::operation_aborted;
+            }
+        } else if( nResult != -ENOBUFS ) {
+            // ENOBUFS: the provided buffers ran out, the multishot read just has to be armed again
+            readError = _result_error( nResult );
+        }
+
+        if( readError && fnRead ) {
+            fnDone = std::move( fnRead );
+            fnRead = nullptr;
+            ec = readError;
+            readError = {};
+        }
+
+        if( bLast ) {
+            operation.bInFlight = false;
+            if( bMultishot && ( nResult > 0 || nResult == -ENOBUFS ) ) {
+                StartRead();
+            }
+        }
+        if( IsIdle() ) {
+            pHold = std::move( pSelf );
+            cv.notify_all();
+        }
+    }
+
+    // Already on the reactor thread and outside of any initiating function - no need to post
+    if( fnDone ) {
+        fnDone( ec, nDone );
+    }
+}
+
+void CUringSerialTransport::CChannel::OnWrite( COperation& operation, int nResult, uint32_t )
+{
+    std::shared_ptr< CChannel > pHold;
+    io_handler_t fnDone;
+    boost::system::error_code ec;
+    size_t nWritten;
+    SWrite& write = &operation == &asyncWrite ? asyncWriteState : syncWriteState;
+    {
+        std::lock_guard< std::mutex > _lck( mtx );
+        operation.bInFlight = false;
+
+        if( nResult > 0 ) {
+            write.nWritten += static_cast< size_t >( nResult );
+            _consume( write.vIov, static_cast< size_t >( nResult ) );
+            if( !write.vIov.empty() && !write.bAborted && fd >= 0 ) {
+                StartWrite( operation, write );
+                return;
+            }
+            if( !write.vIov.empty() ) {
+                write.error = boost::asio::error::operation_aborted;
+            }
+        } else if( nResult == -ECANCELED ) {
+            write.error = write.bAborted ? boost::asio::error::operation_aborted : boost::asio::error::timed_out;
+        } else {
+            write.error = nResult < 0 ? _result_error( nResult ) : boost::asio::error::eof;
+        }
+
+        write.bDone = true;
+        ec = write.error;
+        nWritten = write.nWritten;
+        fnDone = std::move( write.fnHandler );
+        write.fnHandler = nullptr;
+        if( IsIdle() ) {
+            pHold = std::move( pSelf );
+        }
+        cv.notify_all();
+    }
+
+    if( fnDone ) {
+        fnDone( ec, nWritten );
+    }
+}
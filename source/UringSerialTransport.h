@@ -0,0 +1,121 @@
+#pragma once
+
+#include <condition_variable>
+#include "Transport.h"
+#include "UringReactor.h"
+
+// A serial device node served by the shared CUringReactor. Reads are one multishot read per port into
+// the reactor's provided buffers where the kernel has it, otherwise a single-shot read per AsyncReadSome()
+// into a registered slot. Writes are gather writes with a linked timeout sized to the line speed, so a port
+// stuck in flow control fails the write with timed_out instead of hanging the caller; the blocking Write()
+// of a line without flow control, which cannot get stuck, is a plain writev().
+// The handlers are called from the reactor thread, never from the initiating function.
+// One read and one asynchronous write may be pending at a time, plus any blocking Write()
+class CUringSerialTransport : public CTransport {
+public:
+    // False if the kernel cannot serve the transport. CTransport::Create() then falls back to epoll
+    static bool IsSupported();
+
+    explicit CUringSerialTransport( std::string strName );
+    ~CUringSerialTransport() override;
+
+    std::string GetName() const override { return m_strName; }
+
+    void Open( const std::string& strDevicePath, boost::system::error_code& ec ) override;
+    bool IsOpen() const override;
+    void Close() override;
+    void Cancel() override;
+
+    void SetLineSettings( const SLineSettings& settings, boost::system::error_code& ec ) override;
+
+    void AsyncReadSome( boost::asio::mutable_buffer buffer, io_handler_t fnHandler ) override;
+    void AsyncWrite( const boost::asio::const_buffer* pBuffers, size_t nBuffers, io_handler_t fnHandler ) override;
+    size_t Write( const boost::asio::const_buffer* pBuffers, size_t nBuffers, boost::system::error_code& ec ) override;
+
+    int GetTtyHandle() override;
+    bool HasOwnReactor() const override { return true; }
+    uint64_t GetRxOverflowCount() const override { return m_channel->nBacklogOverflow.load( std::memory_order_relaxed ); }
+
+private:
+    class CChannel;
+
+    // One kind of operation of the channel, in flight at most once at a time
+    class COperation : public CUringReactor::IOperation {
+    public:
+        COperation( CChannel& channel, void ( CChannel::*pfnComplete )( COperation&, int, uint32_t ) )
+            : m_channel( channel ), m_pfnComplete{ pfnComplete } {}
+
+        void OnComplete( int nResult, uint32_t nFlags ) override;
+
+        bool bInFlight{ false };
+
+    private:
+        CChannel& m_channel;
+        void ( CChannel::*m_pfnComplete )( COperation&, int, uint32_t );
+    };
+
+    // A gather write and its timeout. Kept with the operation until the last completion
+    struct SWrite {
+        std::vector< iovec > vIov;      // what is left to write
+        __kernel_timespec timeout{};
+        size_t nWritten{ 0 };
+        boost::system::error_code error;
+        io_handler_t fnHandler;         // empty for the blocking Write()
+        bool bAborted{ false };         // cancelled by Cancel()/Close() rather than the timeout
+        bool bDone{ false };
+    };
+
+    // The descriptor and its operations. Shared with the reactor: the kernel may still complete an
+    // operation, cancelled or not, after the transport has closed the descriptor
+    class CChannel : public std::enable_shared_from_this< CChannel > {
+    public:
+        CChannel();
+        ~CChannel();
+
+        // Under mtx
+        void StartRead();
+        void StartWrite( COperation& operation, SWrite& write );
+        bool IsIdle() const { return !read.bInFlight && !asyncWrite.bInFlight && !syncWrite.bInFlight; }
+
+        void OnRead( COperation& operation, int nResult, uint32_t nFlags );
+        // Reactor thread: submits the multishot read StartRead() handed over, unless closed meanwhile
+        void ArmMultishotRead();
+        // Under mtx. Keeps what fits into the backlog, counts the rest as overflow
+        void AppendBacklog( const uint8_t* pData, size_t nSize );
+        void OnWrite( COperation& operation, int nResult, uint32_t nFlags );
+
+        CUringReactor& reactor;
+
+        std::mutex mtx;
+        std::condition_variable cv;     // an operation has finished
+        // Changed under mtx. Read without it by the tty tuning
+        std::atomic< int > fd{ -1 };
+        std::atomic< uint32_t > nBaud{ 9600 };
+        std::atomic< bool > bFlowControl{ false };
+        // Holds the channel while the kernel has any of its operations
+        std::shared_ptr< CChannel > pSelf;
+
+        COperation read;
+        int nSlot{ -1 };                // registered slot of the single-shot reads
+        std::vector< uint8_t > vReadBuffer;  // used when no slot is left
+        // Received while no read was pending, or an error to report to the next one. Bounded by BACKLOG_CAPACITY
+        std::vector< uint8_t > vBacklog;
+        std::atomic< uint64_t > nBacklogOverflow{ 0 };
+        boost::system::error_code readError;
+        boost::asio::mutable_buffer readBuffer;
+        io_handler_t fnRead;
+        bool bReadArmPending{ false };  // read is in flight for the transport but not submitted yet
+
+        COperation asyncWrite;
+        SWrite asyncWriteState;
+        COperation syncWrite;
+        SWrite syncWriteState;
+        // Blocking Write() calls doing a plain writev() on fd, guarded by mtx. Close() waits for them on cv
+        size_t nPlainWriters{ 0 };
+    };
+
+private:
+    std::string m_strName;
+    std::shared_ptr< CChannel > m_channel;
+    std::mutex m_sync_write_mtx;
+};
@@ -6,11 +6,15 @@
 #include <cerrno>   /* Error number definitions */
 #include <termios.h> /* POSIX terminal control definitions */
 #include <sys/ioctl.h>
+#include <future>
 #include "itl_types.h"
 #include "serialfunc.h"
+#include "SerialPortManager.h"
 
 namespace {
     std::mutex g_log_mtx;
+    std::atomic< bool > g_bLowLatencyProfile{ false };
+    std::atomic< bool > g_bEchoSuppression{ false };
 }
 
 void _itl_ssp_set_comm_logger( )
@@ -18,6 +22,36 @@ void _itl_ssp_set_comm_logger( )
     std::lock_guard< std::mutex > _{ g_log_mtx };
 }
 
+void _itl_ssp_set_io_threads_count( size_t nThreads )
+{
+    CSerialPortManager::Instance().SetThreadsCount( nThreads );
+}
+
+void _itl_ssp_set_thread_attributes( EThreadRole eRole, const SThreadAttributes& attributes )
+{
+    CLibraryThread::SetAttributes( eRole, attributes );
+}
+
+std::vector< SThreadState > _itl_ssp_get_thread_states()
+{
+    return CLibraryThread::GetThreadStates();
+}
+
+void _itl_ssp_set_serial_backend( CTransport::ESerialBackend eBackend )
+{
+    CTransport::SetSerialBackend( eBackend );
+}
+
+void _itl_ssp_set_low_latency_profile( bool bEnable )
+{
+    g_bLowLatencyProfile = bEnable;
+}
+
+void _itl_ssp_set_echo_suppression( bool bEnable )
+{
+    g_bEchoSuppression = bEnable;
+}
+
 // port is the device name ( eg /dev/ttyACM0 )
 // returns -1 on error
 /*
@@ -39,17 +73,51 @@ SSP_PORT OpenSSPPort(const char * port)
         8, boost::asio::serial_port_base::stop_bits::two
     ) );
 
+    pPort->SetLowLatencyProfile( g_bLowLatencyProfile );
+    pPort->SetEchoSuppression( g_bEchoSuppression );
+
     if( !pPort->Open() ) {
         pPort.reset();
         return {};
     }
     pPort->_setNV200WierdDeinitializationRequired();
 
+    // SSP replies are assembled by the reader thread
+    pPort->EnableFrameDecoding( true );
+
     pPort->StartThread();
 
     return pPort;
 }
 
+/*
+    Name: OpenSSPPorts
+    Inputs:
+        std::vector< std::string > vPorts: The names of the ports to open
+    Return:
+        The handles in the order of vPorts, empty for the ports that failed to open
+    Notes:
+        The ports are opened concurrently, one thread each
+*/
+
+std::vector< SSP_PORT > OpenSSPPorts( const std::vector< std::string >& vPorts )
+{
+    std::vector< std::future< SSP_PORT > > vOpens;
+    std::vector< CLibraryThread > vThreads;
+    for( const auto& strPort : vPorts ) {
+        std::packaged_task< SSP_PORT() > open( [ &strPort ] { return OpenSSPPort( strPort.c_str() ); } );
+        vOpens.push_back( open.get_future() );
+        vThreads.emplace_back( EThreadRole::Discovery, std::move( open ) );
+    }
+
+    std::vector< SSP_PORT > vResult;
+    vResult.reserve( vPorts.size() );
+    for( auto& open : vOpens ) {
+        vResult.push_back( open.get() );
+    }
+    return vResult;
+}
+
 /*
 Name: CloseSSPPort
 Inputs:
@@ -70,9 +138,7 @@ uint32_t WriteData( const unsigned char * data, uint32_t length, const SSP_PORT_
 {
     if( auto pPort = port.lock() ) {
 
-        std::vector< uint8_t > vData;
-        std::copy( data, data + length, std::back_inserter( vData ) );
-        if( !pPort->Write( vData, bClearRxAccumulator ) ) {
+        if( !pPort->Write( data, length, bClearRxAccumulator ) ) {
             return 0;
         }
         return length;
@@ -80,19 +146,53 @@ uint32_t WriteData( const unsigned char * data, uint32_t length, const SSP_PORT_
     return 0;
 }
 
-int ReadSingleByte( const SSP_PORT_WP& port, unsigned char* buffer, uint32_t nTimeoutMs, bool bClearAccumulator )
+uint32_t WriteData( const unsigned char* data, uint32_t length, const SSP_PORT_WP& port, bool bClearRxAccumulator, std::chrono::steady_clock::time_point& tDrained )
+{
+    if( auto pPort = port.lock() ) {
+
+        CThreadedSerialPort::SWriteCompletion completion;
+        if( !pPort->Write( data, length, completion, bClearRxAccumulator ) ) {
+            return 0;
+        }
+        tDrained = completion.tDrained;
+        return length;
+    }
+    return 0;
+}
+
+uint32_t WriteDataV( const boost::asio::const_buffer* buffers, size_t count, const SSP_PORT_WP& port, bool bClearRxAccumulator )
 {
     if( auto pPort = port.lock() ) {
-        auto result = pPort->WaitForIncomingData( 1, nTimeoutMs, bClearAccumulator );
-        if( !result.first ) {
+        if( !pPort->Write( buffers, count, bClearRxAccumulator ) ) {
             return 0;
         }
-        *buffer = result.second[ 0 ];
-        return 1;
+        size_t nTotal{ 0 };
+        for( size_t i = 0; i < count; ++i ) {
+            nTotal += buffers[ i ].size();
+        }
+        return static_cast< uint32_t >( nTotal );
+    }
+    return 0;
+}
+
+int ReadSingleByte( const SSP_PORT_WP& port, unsigned char* buffer, uint32_t nTimeoutMs, bool bClearAccumulator )
+{
+    if( auto pPort = port.lock() ) {
+        boost::system::error_code ec;
+        return static_cast< int >( pPort->WaitForIncomingData( buffer, 1, nTimeoutMs, ec, bClearAccumulator ) );
     }
     return 0;
 }
 
+bool ReadFrame( const SSP_PORT_WP& port, unsigned char nAddress, SSspFrame& frame, uint32_t nTimeoutMs, boost::system::error_code& ec )
+{
+    if( auto pPort = port.lock() ) {
+        return pPort->WaitForFrame( nAddress, std::chrono::steady_clock::now() + std::chrono::milliseconds( nTimeoutMs ), frame, ec );
+    }
+    ec = boost::asio::error::bad_descriptor;
+    return false;
+}
+
 void SetBaud( const SSP_PORT_WP& port, const unsigned long baud )
 {
     if( auto pPort = port.lock() ) {
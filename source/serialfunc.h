@@ -2,8 +2,17 @@
 
 uint32_t WriteData( const unsigned char* data, uint32_t length, const SSP_PORT_WP& port, bool bClearRxAccumulator );
 
+// Also reports when the port sends the last byte out, estimated from the kernel output queue without waiting
+uint32_t WriteData( const unsigned char* data, uint32_t length, const SSP_PORT_WP& port, bool bClearRxAccumulator, std::chrono::steady_clock::time_point& tDrained );
+
+// Writes the buffers in order with no intermediate copy. Returns the total number of bytes written or 0 on error
+uint32_t WriteDataV( const boost::asio::const_buffer* buffers, size_t count, const SSP_PORT_WP& port, bool bClearRxAccumulator );
+
 int ReadSingleByte( const SSP_PORT_WP& port, unsigned char* buffer, uint32_t nTimeoutMs, bool bClearAccumulator );
 
+// On failure ec tells a timeout from a corrupted reply (bad_message), see CThreadedSerialPort::WaitForFrame()
+bool ReadFrame( const SSP_PORT_WP& port, unsigned char nAddress, SSspFrame& frame, uint32_t nTimeoutMs, boost::system::error_code& ec );
+
 void SetBaud( const SSP_PORT_WP& port, const unsigned long baud );
 
 void _itl_ssp_set_comm_logger();
@@ -3,6 +3,8 @@
 #include <cstdio>
 #include <cstring>
 #include <utility>
+#include <algorithm>
+#include <iterator>
 #include <unistd.h>
 
 
@@ -170,6 +172,72 @@ SSP_RESPONSE_ENUM ssp_sync(SSP_COMMAND_SETUP setup)
     return resp;
 }
 
+namespace {
+    // Rates of SSP_CMD_SET_BAUD_RATE, indexed by its code
+    const unsigned long g_SspBaudRates[] = { 9600, 38400, 115200 };
+    // The unit replies at the old rate and switches once the reply is out
+    const useconds_t SSP_BAUD_SWITCH_DELAY_US = 50000;
+    // Verification SYNCs at the new rate before giving up on it. The unit may still be switching
+    const int SSP_BAUD_VERIFY_ATTEMPTS = 3;
+}
+
+SSP_RESPONSE_ENUM ssp_set_baud_rate(SSP_COMMAND_SETUP setup, const unsigned long baud, unsigned long * effective_baud)
+{
+    SSP_COMMAND sspC;
+    SSP_RESPONSE_ENUM resp;
+    auto pPort = setup.port.lock();
+    if (!pPort)
+    {
+        *effective_baud = 0;
+        return SSP_RESPONSE_TIMEOUT;
+    }
+    const unsigned long old_baud = pPort->GetBaudrate();
+    *effective_baud = old_baud;
+
+    const auto code = std::find(std::begin(g_SspBaudRates), std::end(g_SspBaudRates), baud);
+    if (code == std::end(g_SspBaudRates))
+        return SSP_RESPONSE_INVALID_PARAMETER;
+
+    // Both ends agree on the sequence bit before the switch
+    resp = ssp_sync(setup);
+    if (resp != SSP_RESPONSE_OK || baud == old_baud)
+        return resp;
+
+    _ssp_setup_command_structure(&setup,&sspC);
+    sspC.CommandDataLength = 3;
+    sspC.CommandData[0] = SSP_CMD_SET_BAUD_RATE;
+    sspC.CommandData[1] = static_cast< unsigned char >(code - std::begin(g_SspBaudRates));
+    sspC.CommandData[2] = 0;    // until the unit resets
+    resp = _ssp_return_values(setup.port, &sspC);
+    if (resp != SSP_RESPONSE_OK)
+        return resp;
+
+    usleep(SSP_BAUD_SWITCH_DELAY_US);
+    if (pPort->SetBaudrate(static_cast< uint32_t >(baud)))
+    {
+        // Verification round trips at the new rate
+        for (int attempt = 0; attempt < SSP_BAUD_VERIFY_ATTEMPTS; ++attempt)
+        {
+            pPort->PurgeRxBuffer();
+            if (ssp_sync(setup) == SSP_RESPONSE_OK)
+            {
+                *effective_baud = baud;
+                return SSP_RESPONSE_OK;
+            }
+        }
+    }
+
+    // The host side or the link cannot carry the new rate. Back to the old one, where the unit still
+    // answers if it did not switch either
+    pPort->SetBaudrate(static_cast< uint32_t >(old_baud));
+    pPort->PurgeRxBuffer();
+    if (ssp_sync(setup) == SSP_RESPONSE_OK)
+        return SSP_RESPONSE_FAILURE;
+
+    // The unit acknowledged the switch but answers at neither rate
+    return SSP_RESPONSE_BAUD_RATE_UNKNOWN;
+}
+
 SSP_RESPONSE_ENUM ssp_disable(SSP_COMMAND_SETUP setup)
 {
     SSP_COMMAND sspC;
@@ -23,6 +23,7 @@
 #define SSP_CMD_CHANNEL_SECURITY 0xF
 #define SSP_CMD_CHANNEL_RETEACH 0x10
 #define SSP_CMD_SYNC 0x11
+#define SSP_CMD_SET_BAUD_RATE 0x4D
 #define SSP_CMD_DISPENSE 0x12
 #define SSP_CMD_PROGRAM_STATUS 0x16
 #define SSP_CMD_LAST_REJECT 0x17
@@ -67,6 +68,7 @@ SSP_RESPONSE_HEADER_FAILURE = 0xF9,
 SSP_RESPONSE_KEY_NOT_SET = 0xFA,
 SSP_RESPONSE_TIMEOUT = 0xFF,
 SSP_RESPONSE_COMMAND_NOT_PROCESSED_BUSY = 0xF503,
+SSP_RESPONSE_BAUD_RATE_UNKNOWN = 0xF801,    // host side: the unit answers at neither the old nor the new baud rate
 } SSP_RESPONSE_ENUM;
 
 
@@ -9,20 +9,20 @@
 using namespace std;
 
 // convert UTF-8 string to wstring
-std::wstring utf8_to_wstring (const std::string& str)
+inline std::wstring utf8_to_wstring (const std::string& str)
 {
     std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
     return myconv.from_bytes(str);
 }
 
 // convert wstring to UTF-8 string
-std::string wstring_to_utf8 (const std::wstring& str)
+inline std::string wstring_to_utf8 (const std::wstring& str)
 {
     std::wstring_convert<std::codecvt_utf8<wchar_t>> myconv;
     return myconv.to_bytes(str);
 }
 
-std::wstring remove_control_chars( const std::wstring& refStr )
+inline std::wstring remove_control_chars( const std::wstring& refStr )
 {
     std::wstring strResult;
     std::wstring::const_iterator it = refStr.begin();
@@ -36,7 +36,7 @@ std::wstring remove_control_chars( const std::wstring& refStr )
     return strResult;
 }
 
-std::wstring dump_bin_as_string( const uint8_t* pStart, const uint8_t* pEnd, size_t nIndent, size_t nColumns = 16, wchar_t chAsciiBlockDelimiter = L'|')
+inline std::wstring dump_bin_as_string( const uint8_t* pStart, const uint8_t* pEnd, size_t nIndent, size_t nColumns = 16, wchar_t chAsciiBlockDelimiter = L'|')
 {
     std::wstring strIndent( nIndent, L'\t' );
     std::wostringstream symbols, tmp_str;
@@ -84,12 +84,12 @@ std::wstring dump_bin_as_string( const uint8_t* pStart, const uint8_t* pEnd, siz
     return tmp_str.str();
 }
 
-std::wstring dump_bin_as_string( const std::vector< uint8_t >& _data, size_t nIndent, size_t nColumns = 16, wchar_t chAsciiBlockDelimiter = L'|')
+inline std::wstring dump_bin_as_string( const std::vector< uint8_t >& _data, size_t nIndent, size_t nColumns = 16, wchar_t chAsciiBlockDelimiter = L'|')
 {
     return dump_bin_as_string(_data.data(), _data.data() + _data.size(), nIndent, nColumns, chAsciiBlockDelimiter);
 }
 
-std::wstring dump_bin_as_string(const uint8_t* pStart, size_t nSize, size_t nIndent, size_t nColumns = 16, wchar_t chAsciiBlockDelimiter = L'|')
+inline std::wstring dump_bin_as_string(const uint8_t* pStart, size_t nSize, size_t nIndent, size_t nColumns = 16, wchar_t chAsciiBlockDelimiter = L'|')
 {
     return dump_bin_as_string(pStart, pStart + nSize, nIndent, nColumns, chAsciiBlockDelimiter);
 }
@@ -0,0 +1,84 @@
+#define BOOST_TEST_MODULE crc16
+#include <boost/test/included/unit_test.hpp>
+
+#include "Crc16.h"
+#include "Encryption.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+    // The original cal_crc_loop_CCITT_A() loop, before it dispatched to CCrc16
+    uint16_t _reference_crc( const uint8_t* pData, size_t nSize, uint16_t nSeed )
+    {
+        uint16_t crc = nSeed;
+        for( size_t i = 0; i < nSize; ++i ) {
+            crc ^= static_cast< uint16_t >( pData[ i ] << 8 );
+            for( int j = 0; j < 8; ++j ) {
+                crc = ( crc & 0x8000 ) ? static_cast< uint16_t >( ( crc << 1 ) ^ CCrc16::POLY ) : static_cast< uint16_t >( crc << 1 );
+            }
+        }
+        return crc;
+    }
+
+    const CCrc16::EEngine ENGINES[] = { CCrc16::EEngine::Bitwise, CCrc16::EEngine::Table, CCrc16::EEngine::SliceBy8, CCrc16::EEngine::Clmul };
+}
+
+BOOST_AUTO_TEST_CASE( check_value )
+{
+    // CRC-16/BUYPASS has the same polynomial and no reflection, seeded with 0 instead of 0xFFFF
+    const uint8_t check[] = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+    BOOST_TEST( _reference_crc( check, sizeof( check ), 0 ) == 0xFEE8 );
+    for( auto eEngine : ENGINES ) {
+        BOOST_TEST( CCrc16::Compute( eEngine, check, sizeof( check ), 0 ) == 0xFEE8 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( engines_match_reference )
+{
+    std::mt19937 rng( 2021 );
+    std::vector< uint8_t > buffer( 4096 + 64 );
+    for( auto& byte : buffer ) {
+        byte = static_cast< uint8_t >( rng() );
+    }
+
+    // Every length around the 8 byte slices and the 64 byte folding rounds, at every alignment of a vector
+    for( size_t nSize = 0; nSize <= 600; ++nSize ) {
+        for( size_t nOffset = 0; nOffset < 64; nOffset += ( nSize < 300 ? 1 : 7 ) ) {
+            const uint8_t* pData = buffer.data() + nOffset;
+            const uint16_t nSeed = static_cast< uint16_t >( rng() );
+            const uint16_t nExpected = _reference_crc( pData, nSize, nSeed );
+            for( auto eEngine : ENGINES ) {
+                if( CCrc16::Compute( eEngine, pData, nSize, nSeed ) != nExpected ) {
+                    BOOST_ERROR( "engine " << static_cast< int >( eEngine ) << " size " << nSize << " offset " << nOffset );
+                }
+            }
+            BOOST_REQUIRE( CCrc16::Compute( pData, nSize, nSeed ) == nExpected );
+        }
+    }
+
+    // Random long buffers
+    for( int i = 0; i < 2000; ++i ) {
+        const size_t nSize = rng() % 4097;
+        const size_t nOffset = rng() % 64;
+        const uint16_t nSeed = static_cast< uint16_t >( rng() );
+        const uint16_t nExpected = _reference_crc( buffer.data() + nOffset, nSize, nSeed );
+        for( auto eEngine : ENGINES ) {
+            BOOST_REQUIRE( CCrc16::Compute( eEngine, buffer.data() + nOffset, nSize, nSeed ) == nExpected );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( legacy_entry_point )
+{
+    std::mt19937 rng( 8005 );
+    std::vector< uint8_t > buffer( 300 );
+    for( int i = 0; i < 1000; ++i ) {
+        for( auto& byte : buffer ) {
+            byte = static_cast< uint8_t >( rng() );
+        }
+        const size_t nSize = rng() % buffer.size();
+        BOOST_REQUIRE( cal_crc_loop_CCITT_A( static_cast< short >( nSize ), buffer.data(), CRC_SSP_SEED, CRC_SSP_POLY )
+                       == _reference_crc( buffer.data(), nSize, CRC_SSP_SEED ) );
+    }
+}
@@ -0,0 +1,43 @@
+#define BOOST_TEST_MODULE fixed_frames
+#include <boost/test/included/unit_test.hpp>
+
+#include "SSPFixedFrames.h"
+#include "SSPFrameEncoder.h"
+#include "ssp_defines.h"
+
+#include <set>
+
+BOOST_AUTO_TEST_CASE( frames_match_encoder )
+{
+    std::set< unsigned > commands;
+    for( unsigned nCommand = 0; nCommand <= 255; ++nCommand ) {
+        for( unsigned nSeqAddress = 0; nSeqAddress <= 255; ++nSeqAddress ) {
+            const uint8_t command = static_cast< uint8_t >( nCommand );
+            const SSspFixedFrame* pFrame = SSPFindFixedFrame( command, static_cast< uint8_t >( nSeqAddress ) );
+            if( !pFrame ) {
+                // A command is fixed for every SEQ/ADDR or for none
+                BOOST_REQUIRE( commands.count( nCommand ) == 0 );
+                continue;
+            }
+            BOOST_REQUIRE( nSeqAddress == 0 || commands.count( nCommand ) == 1 );
+            commands.insert( nCommand );
+
+            uint8_t encoded[ 16 ];
+            const size_t nSize = CSSPFrameEncoder( static_cast< uint8_t >( nSeqAddress ), &command, 1 ).Encode( encoded, sizeof( encoded ) );
+            BOOST_REQUIRE( pFrame->length == nSize );
+            for( size_t i = 0; i < nSize; ++i ) {
+                if( pFrame->data[ i ] != encoded[ i ] ) {
+                    BOOST_FAIL( "command " << nCommand << " seq/addr " << nSeqAddress << " byte " << i );
+                }
+            }
+        }
+    }
+
+    // The commands sent with no data are all in the table
+    for( unsigned nCommand : { SSP_CMD_RESET, SSP_CMD_SETUP_REQUEST, SSP_CMD_POLL, SSP_CMD_REJECT_NOTE, SSP_CMD_DISABLE,
+                               SSP_CMD_ENABLE, SSP_CMD_SERIAL_NUMBER, SSP_CMD_SYNC, SSP_CMD_HOLD, SSP_CMD_EMPTY,
+                               SSP_CMD_SMART_EMPTY, SSP_CMD_GET_ALL_LEVELS, SSP_CMD_ENABLE_HIGHER_PROTOCOL } ) {
+        BOOST_TEST( commands.count( nCommand ) == 1u );
+    }
+    BOOST_TEST( commands.size() == 23u );
+}
@@ -0,0 +1,197 @@
+#define BOOST_TEST_MODULE frame_decoder
+#include <boost/test/included/unit_test.hpp>
+
+#include "SSPFrameDecoder.h"
+#include "SSPFrameEncoder.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+    const uint8_t STX = 0x7F;
+
+    std::vector< uint8_t > _encode( uint8_t nSeqAddress, const std::vector< uint8_t >& data )
+    {
+        CSSPFrameEncoder encoder( nSeqAddress, data.data(), static_cast< uint8_t >( data.size() ) );
+        std::vector< uint8_t > frame( encoder.EncodedSize() );
+        encoder.Encode( frame.data(), frame.size() );
+        return frame;
+    }
+
+    // Feeds the stream in chunks of nChunk bytes, returns the frames as they would be encoded again
+    std::vector< std::vector< uint8_t > > _decode( CSSPFrameDecoder& decoder, const std::vector< uint8_t >& stream, size_t nChunk )
+    {
+        std::vector< std::vector< uint8_t > > frames;
+        size_t nReported{ 0 };
+        for( size_t i = 0; i < stream.size(); i += nChunk ) {
+            nReported += decoder.Feed( stream.data() + i, std::min( nChunk, stream.size() - i ), [ & ]( const SSspFrame& frame ) {
+                frames.push_back( _encode( frame.data[ 1 ], std::vector< uint8_t >( frame.data + 3, frame.data + frame.length - 2 ) ) );
+            } );
+        }
+        BOOST_REQUIRE( nReported == frames.size() );
+        return frames;
+    }
+
+    // Every byte received is either in a reported frame or counted as discarded
+    size_t _raw_size( const std::vector< std::vector< uint8_t > >& frames )
+    {
+        size_t nSize{ 0 };
+        for( const auto& frame : frames ) {
+            nSize += frame.size();
+        }
+        return nSize;
+    }
+
+    const std::vector< uint8_t > POLL_REPLY{ 0xF0, 0xEF, 0x01, STX, 0x02 };
+}
+
+BOOST_AUTO_TEST_CASE( noise_then_frame )
+{
+    const std::vector< uint8_t > frame = _encode( 0x80, POLL_REPLY );
+    std::vector< uint8_t > stream{ 0x00, 0x11, 0xFF, 0x12 };
+    stream.insert( stream.end(), frame.begin(), frame.end() );
+
+    for( size_t nChunk : { size_t{ 1 }, size_t{ 3 }, stream.size() } ) {
+        CSSPFrameDecoder decoder;
+        const auto frames = _decode( decoder, stream, nChunk );
+        BOOST_REQUIRE( frames.size() == 1u );
+        BOOST_TEST( frames[ 0 ] == frame );
+        BOOST_TEST( decoder.GetStatistics().nFrames == 1u );
+        BOOST_TEST( decoder.GetStatistics().nDiscardedBytes == 4u );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( crc_error_then_frame )
+{
+    std::vector< uint8_t > stream = _encode( 0x00, { 0x11 } );
+    stream.back() ^= 0x01;
+    const size_t nBad = stream.size();
+    const std::vector< uint8_t > frame = _encode( 0x80, POLL_REPLY );
+    stream.insert( stream.end(), frame.begin(), frame.end() );
+
+    for( size_t nChunk : { size_t{ 1 }, stream.size() } ) {
+        CSSPFrameDecoder decoder;
+        const auto frames = _decode( decoder, stream, nChunk );
+        BOOST_REQUIRE( frames.size() == 1u );
+        BOOST_TEST( frames[ 0 ] == frame );
+        BOOST_TEST( decoder.GetStatistics().nCrcErrors == 1u );
+        BOOST_TEST( decoder.GetStatistics().nDiscardedBytes == nBad );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( noise_stx_before_frame )
+{
+    // The noise STX and the real one read as a stuffed STX for SEQ/ADDR: the frame is found behind it
+    std::vector< uint8_t > stream{ STX };
+    const std::vector< uint8_t > frame = _encode( 0x80, POLL_REPLY );
+    stream.insert( stream.end(), frame.begin(), frame.end() );
+
+    for( size_t nChunk : { size_t{ 1 }, stream.size() } ) {
+        CSSPFrameDecoder decoder;
+        const auto frames = _decode( decoder, stream, nChunk );
+        BOOST_REQUIRE( frames.size() == 1u );
+        BOOST_TEST( frames[ 0 ] == frame );
+        BOOST_TEST( decoder.GetStatistics().nFalseStarts == 1u );
+        BOOST_TEST( decoder.GetStatistics().nDiscardedBytes == 1u );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( truncated_frame_then_frame )
+{
+    // A frame cut short after its header: the next STX restarts
+    std::vector< uint8_t > stream = _encode( 0x81, std::vector< uint8_t >( 40, 0x22 ) );
+    stream.resize( 10 );
+    const std::vector< uint8_t > frame = _encode( 0x80, POLL_REPLY );
+    stream.insert( stream.end(), frame.begin(), frame.end() );
+
+    CSSPFrameDecoder decoder;
+    const auto frames = _decode( decoder, stream, 4 );
+    BOOST_REQUIRE( frames.size() == 1u );
+    BOOST_TEST( frames[ 0 ] == frame );
+    BOOST_TEST( decoder.GetStatistics().nFalseStarts == 1u );
+    BOOST_TEST( decoder.GetStatistics().nDiscardedBytes == 10u );
+}
+
+BOOST_AUTO_TEST_CASE( long_stx_noise_then_frame )
+{
+    // Each pair of noise STX fails as a frame start and is replayed from its second byte: long runs of them
+    // replay over and over, within the chunk and across chunks
+    for( size_t nNoise : { 1u, 2u, 3u, 255u, 256u, 1000u, 4001u } ) {
+        std::vector< uint8_t > stream( nNoise, STX );
+        const std::vector< uint8_t > frame = _encode( 0x80, POLL_REPLY );
+        stream.insert( stream.end(), frame.begin(), frame.end() );
+
+        for( size_t nChunk : { size_t{ 1 }, size_t{ 7 }, stream.size() } ) {
+            CSSPFrameDecoder decoder;
+            const auto frames = _decode( decoder, stream, nChunk );
+            BOOST_REQUIRE( frames.size() == 1u );
+            BOOST_TEST( frames[ 0 ] == frame );
+            BOOST_TEST( decoder.GetStatistics().nDiscardedBytes == nNoise );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( random_corruption )
+{
+    std::mt19937 rng( 25 );
+    for( int nRound = 0; nRound < 2000; ++nRound ) {
+        std::vector< uint8_t > stream;
+        std::vector< std::vector< uint8_t > > expected;
+        uint64_t nCorrupted{ 0 };
+        for( int nFrame = 0; nFrame < 8; ++nFrame ) {
+            // SEQ/ADDR 0x7F would make the doubled STX ambiguous, no device has that address
+            const uint8_t nSeqAddress = static_cast< uint8_t >( ( rng() & 0x80 ) | ( rng() % 0x7F ) );
+            std::vector< uint8_t > data( 1 + rng() % ( rng() % 8 ? 16 : 250 ) );
+            for( auto& byte : data ) {
+                byte = rng() % 4 ? static_cast< uint8_t >( rng() ) : STX;
+            }
+            std::vector< uint8_t > frame = _encode( nSeqAddress, data );
+
+            const size_t nCorruptedStart = stream.size();
+            switch( rng() % 4 ) {
+                case 0:     // noise, STX included
+                    for( size_t n = rng() % 32; n > 0; --n ) {
+                        stream.push_back( rng() % 3 ? static_cast< uint8_t >( rng() ) : STX );
+                    }
+                    ++nCorrupted;
+                    break;
+                case 1:     // a bit flipped
+                    frame[ 1 + rng() % ( frame.size() - 1 ) ] ^= static_cast< uint8_t >( 1u << ( rng() % 8 ) );
+                    stream.insert( stream.end(), frame.begin(), frame.end() );
+                    ++nCorrupted;
+                    break;
+                case 2:     // cut short
+                    stream.insert( stream.end(), frame.begin(), frame.begin() + 1 + rng() % ( frame.size() - 1 ) );
+                    ++nCorrupted;
+                    break;
+                default:
+                    break;
+            }
+            // Then a valid frame, which must come out whatever came before. Unless an STX comes right before it:
+            // that one and the frame STX read as a stuffed STX, the frame start is lost and the noise frame goes on
+            while( stream.size() > nCorruptedStart && stream.back() == STX ) {
+                stream.pop_back();
+            }
+            frame = _encode( nSeqAddress, data );
+            stream.insert( stream.end(), frame.begin(), frame.end() );
+            expected.push_back( frame );
+        }
+
+        CSSPFrameDecoder decoder;
+        const auto frames = _decode( decoder, stream, 1 + rng() % 300 );
+
+        // The valid frames in order, noise passing the CRC by chance may come out in between
+        size_t nFound{ 0 };
+        for( const auto& frame : frames ) {
+            if( nFound < expected.size() && frame == expected[ nFound ] ) {
+                ++nFound;
+            }
+        }
+        BOOST_REQUIRE( nFound == expected.size() );
+        BOOST_REQUIRE( frames.size() <= expected.size() + nCorrupted );
+
+        const auto& stats = decoder.GetStatistics();
+        BOOST_REQUIRE( stats.nFrames == frames.size() );
+        BOOST_REQUIRE( stats.nDiscardedBytes + _raw_size( frames ) == stream.size() );
+    }
+}
@@ -0,0 +1,90 @@
+#define BOOST_TEST_MODULE frame_encoder
+#include <boost/test/included/unit_test.hpp>
+
+#include "SSPFrameEncoder.h"
+#include "Encryption.h"
+
+#include <random>
+#include <vector>
+
+namespace {
+    const uint8_t STX = 0x7F;
+
+    // The frame as CompileSSPCommand() built it before the encoder: header, data and CRC first, then stuffed in a second pass
+    std::vector< uint8_t > _reference_frame( uint8_t nSeqAddress, const uint8_t* pData, uint8_t nLength )
+    {
+        std::vector< uint8_t > frame{ STX, nSeqAddress, nLength };
+        for( uint8_t i = 0; i < nLength; ++i ) {
+            frame.push_back( pData[ i ] );
+        }
+        const unsigned short crc = cal_crc_loop_CCITT_A( static_cast< short >( frame.size() - 1 ), &frame[ 1 ], CRC_SSP_SEED, CRC_SSP_POLY );
+        frame.push_back( static_cast< uint8_t >( crc & 0xFF ) );
+        frame.push_back( static_cast< uint8_t >( ( crc >> 8 ) & 0xFF ) );
+
+        std::vector< uint8_t > stuffed{ frame[ 0 ] };
+        for( size_t i = 1; i < frame.size(); ++i ) {
+            stuffed.push_back( frame[ i ] );
+            if( frame[ i ] == STX ) {
+                stuffed.push_back( STX );
+            }
+        }
+        return stuffed;
+    }
+
+    void _check( uint8_t nSeqAddress, const std::vector< uint8_t >& data )
+    {
+        const uint8_t nLength = static_cast< uint8_t >( data.size() );
+        const std::vector< uint8_t > expected = _reference_frame( nSeqAddress, data.data(), nLength );
+
+        CSSPFrameEncoder encoder( nSeqAddress, data.data(), nLength );
+        BOOST_REQUIRE( encoder.EncodedSize() == expected.size() );
+
+        // Guard bytes after the frame must stay untouched
+        std::vector< uint8_t > out( expected.size() + 8, 0xA5 );
+        BOOST_REQUIRE( encoder.Encode( out.data(), out.size() ) == expected.size() );
+        BOOST_REQUIRE( std::equal( expected.begin(), expected.end(), out.begin() ) );
+        for( size_t i = expected.size(); i < out.size(); ++i ) {
+            BOOST_REQUIRE( out[ i ] == 0xA5 );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( matches_legacy_stuffing )
+{
+    std::mt19937 rng( 23 );
+    // Random data from no STX to only STX, every length, every SEQ/ADDR
+    for( unsigned nDensity : { 0u, 16u, 128u, 256u } ) {
+        for( unsigned nLength = 0; nLength <= 255; ++nLength ) {
+            std::vector< uint8_t > data( nLength );
+            for( auto& byte : data ) {
+                byte = ( rng() % 256 ) < nDensity ? STX : static_cast< uint8_t >( rng() );
+            }
+            _check( static_cast< uint8_t >( rng() ), data );
+        }
+    }
+    for( unsigned nSeqAddress = 0; nSeqAddress <= 255; ++nSeqAddress ) {
+        _check( static_cast< uint8_t >( nSeqAddress ), { 0x11 } );
+        _check( static_cast< uint8_t >( nSeqAddress ), { STX, STX } );
+    }
+    for( int i = 0; i < 20000; ++i ) {
+        std::vector< uint8_t > data( rng() % 256 );
+        for( auto& byte : data ) {
+            byte = rng() % 4 ? static_cast< uint8_t >( rng() ) : STX;
+        }
+        _check( static_cast< uint8_t >( rng() ), data );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( short_buffer_is_rejected )
+{
+    const std::vector< uint8_t > data{ 0x01, STX, 0x02, STX };
+    CSSPFrameEncoder encoder( STX, data.data(), static_cast< uint8_t >( data.size() ) );
+    const size_t nSize = encoder.EncodedSize();
+
+    std::vector< uint8_t > out( nSize, 0xA5 );
+    BOOST_TEST( encoder.Encode( out.data(), nSize - 1 ) == 0u );
+    for( auto byte : out ) {
+        BOOST_REQUIRE( byte == 0xA5 );
+    }
+    BOOST_TEST( encoder.Encode( out.data(), nSize ) == nSize );
+}
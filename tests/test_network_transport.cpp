@@ -0,0 +1,279 @@
+#define BOOST_TEST_MODULE network_transport
+#include <boost/test/included/unit_test.hpp>
+
+#include "Rfc2217Transport.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+    // Telnet and RFC 2217 as seen by the server
+    const uint8_t IAC = 255;
+    const uint8_t DONT = 254;
+    const uint8_t DO = 253;
+    const uint8_t WONT = 252;
+    const uint8_t WILL = 251;
+    const uint8_t SB = 250;
+    const uint8_t SE = 240;
+
+    const uint8_t OPT_BINARY = 0;
+    const uint8_t OPT_ECHO = 1;
+    const uint8_t OPT_SUPPRESS_GO_AHEAD = 3;
+    const uint8_t OPT_COM_PORT = 44;
+
+    using bytes_t = std::vector< uint8_t >;
+
+    // Device server on 127.0.0.1 accepting the transport under test. Both ends are driven from the test thread:
+    // the server side is a blocking socket, the transport completes its reads by running the io_service
+    class CLoopbackServer {
+    public:
+        explicit CLoopbackServer( const std::string& strScheme )
+            : m_acceptor( m_io_service, { boost::asio::ip::address_v4::loopback(), 0 } )
+            , m_peer( m_io_service )
+        {
+            m_transport = CTransport::Create( m_io_service, strScheme + "://127.0.0.1:" + std::to_string( m_acceptor.local_endpoint().port() ) );
+
+            // The connection completes within the listen backlog, it is accepted afterwards
+            boost::system::error_code ec;
+            m_transport->Open( "", ec );
+            BOOST_REQUIRE( !ec );
+            m_acceptor.accept( m_peer );
+        }
+
+        CTransport& Transport() { return *m_transport; }
+        CRfc2217Transport& Rfc2217() { return dynamic_cast< CRfc2217Transport& >( *m_transport ); }
+
+        // Exactly nSize bytes as the server got them
+        bytes_t Receive( size_t nSize )
+        {
+            bytes_t data( nSize );
+            boost::asio::read( m_peer, boost::asio::buffer( data ) );
+            return data;
+        }
+
+        void Send( const bytes_t& data ) { boost::asio::write( m_peer, boost::asio::buffer( data ) ); }
+
+        // One read of the transport: the data bytes of whatever the socket had
+        bytes_t ReadSome()
+        {
+            uint8_t buffer[ 256 ];
+            boost::system::error_code error;
+            size_t nBytes{ 0 };
+            bool bCompleted{ false };
+            m_transport->AsyncReadSome( boost::asio::buffer( buffer ), [ & ]( const boost::system::error_code& ec, size_t n ) {
+                error = ec;
+                nBytes = n;
+                bCompleted = true;
+            } );
+            m_io_service.reset();
+            while( !bCompleted ) {
+                m_io_service.run_one();
+            }
+            BOOST_REQUIRE( !error );
+            return bytes_t( buffer, buffer + nBytes );
+        }
+
+        // Reads until nSize data bytes are collected
+        bytes_t ReadData( size_t nSize )
+        {
+            bytes_t data;
+            while( data.size() < nSize ) {
+                const bytes_t chunk = ReadSome();
+                data.insert( data.end(), chunk.begin(), chunk.end() );
+            }
+            return data;
+        }
+
+        void Write( const bytes_t& data )
+        {
+            boost::asio::const_buffer buffer{ data.data(), data.size() };
+            boost::system::error_code ec;
+            BOOST_TEST( m_transport->Write( &buffer, 1, ec ) == data.size() );
+            BOOST_REQUIRE( !ec );
+        }
+
+        void AsyncWrite( const bytes_t& data )
+        {
+            boost::asio::const_buffer buffer{ data.data(), data.size() };
+            boost::system::error_code error;
+            size_t nBytes{ 0 };
+            bool bCompleted{ false };
+            m_transport->AsyncWrite( &buffer, 1, [ & ]( const boost::system::error_code& ec, size_t n ) {
+                error = ec;
+                nBytes = n;
+                bCompleted = true;
+            } );
+            m_io_service.reset();
+            while( !bCompleted ) {
+                m_io_service.run_one();
+            }
+            BOOST_REQUIRE( !error );
+            BOOST_TEST( nBytes == data.size() );
+        }
+
+    private:
+        boost::asio::io_service m_io_service;
+        boost::asio::ip::tcp::acceptor m_acceptor;
+        boost::asio::ip::tcp::socket m_peer;
+        std::unique_ptr< CTransport > m_transport;
+    };
+
+    bytes_t _com_port_command( uint8_t nCommand, const bytes_t& value )
+    {
+        bytes_t command{ IAC, SB, OPT_COM_PORT, nCommand };
+        command.insert( command.end(), value.begin(), value.end() );
+        command.insert( command.end(), { IAC, SE } );
+        return command;
+    }
+
+    // Takes the option negotiation sent on open off the wire
+    void _negotiate( CLoopbackServer& server )
+    {
+        const bytes_t offer{
+            IAC, WILL, OPT_COM_PORT,
+            IAC, WILL, OPT_BINARY, IAC, DO, OPT_BINARY,
+            IAC, WILL, OPT_SUPPRESS_GO_AHEAD, IAC, DO, OPT_SUPPRESS_GO_AHEAD
+        };
+        BOOST_TEST( server.Receive( offer.size() ) == offer );
+
+        server.Send( { IAC, DO, OPT_COM_PORT, IAC, WILL, OPT_BINARY, IAC, DO, OPT_BINARY,
+                       IAC, WILL, OPT_SUPPRESS_GO_AHEAD, IAC, DO, OPT_SUPPRESS_GO_AHEAD } );
+        while( !server.Rfc2217().IsComPortControlAccepted() ) {
+            BOOST_TEST( server.ReadSome().empty() );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( com_port_option_exchange )
+{
+    CLoopbackServer server( "rfc2217" );
+    BOOST_TEST( !server.Rfc2217().IsComPortControlAccepted() );
+    _negotiate( server );
+
+    // The acknowledgements are not answered: the next bytes on the wire are the data
+    server.Write( { 0x01 } );
+    BOOST_TEST( server.Receive( 1 ) == bytes_t{ 0x01 } );
+
+    // An option nobody offered is refused before the next data goes out
+    server.Send( { IAC, DO, OPT_ECHO, IAC, WILL, OPT_ECHO, 0x42 } );
+    BOOST_TEST( server.ReadData( 1 ) == bytes_t{ 0x42 } );
+    server.Write( { 0x02 } );
+    BOOST_TEST( server.Receive( 7 ) == ( bytes_t{ IAC, WONT, OPT_ECHO, IAC, DONT, OPT_ECHO, 0x02 } ) );
+
+    server.Send( { IAC, DONT, OPT_COM_PORT, 0x43 } );
+    BOOST_TEST( server.ReadData( 1 ) == bytes_t{ 0x43 } );
+    BOOST_TEST( !server.Rfc2217().IsComPortControlAccepted() );
+}
+
+BOOST_AUTO_TEST_CASE( line_settings_payloads )
+{
+    CLoopbackServer server( "rfc2217" );
+    _negotiate( server );
+
+    CTransport::SLineSettings settings;
+    settings.nBaud = 9600;
+    settings.nCharacterSize = 8;
+    settings.parity = boost::asio::serial_port_base::parity::none;
+    settings.stopBits = boost::asio::serial_port_base::stop_bits::two;
+    settings.flowControl = boost::asio::serial_port_base::flow_control::hardware;
+    boost::system::error_code ec;
+    server.Transport().SetLineSettings( settings, ec );
+    BOOST_REQUIRE( !ec );
+
+    bytes_t expected = _com_port_command( 1, { 0x00, 0x00, 0x25, 0x80 } );
+    for( const bytes_t& command : { _com_port_command( 2, { 8 } ), _com_port_command( 3, { 1 } ),
+                                    _com_port_command( 4, { 2 } ), _com_port_command( 5, { 3 } ) } ) {
+        expected.insert( expected.end(), command.begin(), command.end() );
+    }
+    BOOST_TEST( server.Receive( expected.size() ) == expected );
+
+    // 0xFF within a value is doubled
+    settings.nBaud = 0x0001FFFF;
+    settings.nCharacterSize = 7;
+    settings.parity = boost::asio::serial_port_base::parity::even;
+    settings.stopBits = boost::asio::serial_port_base::stop_bits::one;
+    settings.flowControl = boost::asio::serial_port_base::flow_control::software;
+    server.Transport().SetLineSettings( settings, ec );
+    BOOST_REQUIRE( !ec );
+
+    expected = _com_port_command( 1, { 0x00, 0x01, IAC, IAC, IAC, IAC } );
+    for( const bytes_t& command : { _com_port_command( 2, { 7 } ), _com_port_command( 3, { 3 } ),
+                                    _com_port_command( 4, { 1 } ), _com_port_command( 5, { 2 } ) } ) {
+        expected.insert( expected.end(), command.begin(), command.end() );
+    }
+    BOOST_TEST( server.Receive( expected.size() ) == expected );
+
+    // The server reports the rate it applied
+    server.Send( _com_port_command( 101, { 0x00, 0x00, 0x25, 0x80 } ) );
+    server.Send( { 0x44 } );
+    BOOST_TEST( server.ReadData( 1 ) == bytes_t{ 0x44 } );
+    BOOST_TEST( server.Rfc2217().GetServerBaud() == 9600u );
+}
+
+BOOST_AUTO_TEST_CASE( iac_data_escaping )
+{
+    CLoopbackServer server( "rfc2217" );
+    _negotiate( server );
+
+    const bytes_t data{ 0x7F, IAC, 0x00, IAC, IAC, 0x01 };
+    const bytes_t escaped{ 0x7F, IAC, IAC, 0x00, IAC, IAC, IAC, IAC, 0x01 };
+
+    server.Write( data );
+    BOOST_TEST( server.Receive( escaped.size() ) == escaped );
+    server.AsyncWrite( data );
+    BOOST_TEST( server.Receive( escaped.size() ) == escaped );
+
+    server.Send( escaped );
+    BOOST_TEST( server.ReadData( data.size() ) == data );
+}
+
+BOOST_AUTO_TEST_CASE( iac_split_across_reads )
+{
+    CLoopbackServer server( "rfc2217" );
+    _negotiate( server );
+
+    // Escaped data byte
+    server.Send( { 0x10, IAC } );
+    BOOST_TEST( server.ReadSome() == bytes_t{ 0x10 } );
+    server.Send( { IAC, 0x11 } );
+    BOOST_TEST( server.ReadData( 2 ) == ( bytes_t{ IAC, 0x11 } ) );
+
+    // Option command
+    server.Send( { IAC } );
+    BOOST_TEST( server.ReadSome().empty() );
+    server.Send( { DONT } );
+    BOOST_TEST( server.ReadSome().empty() );
+    server.Send( { OPT_COM_PORT, 0x12 } );
+    BOOST_TEST( server.ReadData( 1 ) == bytes_t{ 0x12 } );
+    BOOST_TEST( !server.Rfc2217().IsComPortControlAccepted() );
+
+    // Subnegotiation with an escaped value byte, cut everywhere
+    const bytes_t report = _com_port_command( 101, { 0x00, 0x01, IAC, IAC, 0x00 } );
+    for( size_t i = 0; i < report.size(); ++i ) {
+        server.Send( { report[ i ] } );
+        BOOST_TEST( server.ReadSome().empty() );
+    }
+    server.Send( { 0x13 } );
+    BOOST_TEST( server.ReadData( 1 ) == bytes_t{ 0x13 } );
+    BOOST_TEST( server.Rfc2217().GetServerBaud() == 0x0001FF00u );
+}
+
+BOOST_AUTO_TEST_CASE( tcp_round_trip )
+{
+    CLoopbackServer server( "tcp" );
+
+    // Raw stream: no negotiation, no escaping
+    const bytes_t data{ 0x7F, 0x80, IAC, 0x00, IAC, IAC, SE };
+    server.Write( data );
+    BOOST_TEST( server.Receive( data.size() ) == data );
+    server.AsyncWrite( data );
+    BOOST_TEST( server.Receive( data.size() ) == data );
+
+    server.Send( data );
+    BOOST_TEST( server.ReadData( data.size() ) == data );
+
+    CTransport::SLineSettings settings;
+    boost::system::error_code ec;
+    server.Transport().SetLineSettings( settings, ec );
+    BOOST_TEST( !ec );
+}
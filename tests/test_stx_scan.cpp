@@ -0,0 +1,65 @@
+#define BOOST_TEST_MODULE stx_scan
+#include <boost/test/included/unit_test.hpp>
+
+#include "SSPStxScan.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+    const uint8_t STX = 0x7F;
+
+    size_t _reference_find( const uint8_t* pData, size_t nSize )
+    {
+        const void* pFound = nSize ? std::memchr( pData, STX, nSize ) : nullptr;
+        return pFound ? static_cast< size_t >( static_cast< const uint8_t* >( pFound ) - pData ) : nSize;
+    }
+
+    size_t _reference_count( const uint8_t* pData, size_t nSize )
+    {
+        return static_cast< size_t >( std::count( pData, pData + nSize, STX ) );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( single_stx_at_every_position )
+{
+    // A lone STX at each position of each window, so every vector lane and every scalar tail sees it
+    std::vector< uint8_t > buffer( 160, 0x00 );
+    for( size_t nOffset = 0; nOffset < 32; ++nOffset ) {
+        for( size_t nSize = 0; nSize + nOffset <= 128; ++nSize ) {
+            const uint8_t* pData = buffer.data() + nOffset;
+            BOOST_REQUIRE( SSPFindStx( pData, nSize ) == nSize );
+            BOOST_REQUIRE( SSPCountStx( pData, nSize ) == 0 );
+            for( size_t nAt = 0; nAt < nSize; ++nAt ) {
+                buffer[ nOffset + nAt ] = STX;
+                if( SSPFindStx( pData, nSize ) != nAt || SSPCountStx( pData, nSize ) != 1 ) {
+                    BOOST_ERROR( "offset " << nOffset << " size " << nSize << " at " << nAt );
+                }
+                buffer[ nOffset + nAt ] = 0x00;
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE( random_buffers )
+{
+    std::mt19937 rng( 22 );
+    std::vector< uint8_t > buffer( 1024 + 32 );
+    // From no STX to only STX, any other byte value in between
+    for( unsigned nDensity : { 0u, 1u, 8u, 64u, 200u, 256u } ) {
+        for( auto& byte : buffer ) {
+            const unsigned nRoll = rng() % 256;
+            const unsigned nOther = rng() % 255;
+            byte = nRoll < nDensity ? STX : static_cast< uint8_t >( nOther < STX ? nOther : nOther + 1 );
+        }
+        for( size_t nOffset = 0; nOffset < 32; ++nOffset ) {
+            for( size_t nSize = 0; nSize + nOffset <= buffer.size(); nSize += ( nSize < 100 ? 1 : 13 ) ) {
+                const uint8_t* pData = buffer.data() + nOffset;
+                BOOST_REQUIRE( SSPFindStx( pData, nSize ) == _reference_find( pData, nSize ) );
+                BOOST_REQUIRE( SSPCountStx( pData, nSize ) == _reference_count( pData, nSize ) );
+            }
+        }
+    }
+}